@@ -0,0 +1,618 @@
+/*******************************************************************************
+ * File		: bench.c
+ * Brief	: Benchmark application; measures kernel timings over semihosting
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * Built and run by 'make bench' under QEMU (No board needed). It can also be
+ * flashed onto the board like final_sh.elf.
+ *
+ * All timings are taken from SysTick (CYCLE_COUNT_SYSTICK) since QEMU has no
+ * DWT, and are reported in SysTick counts, i.e. processor cycles on the
+ * target. Under QEMU (-icount) they track executed instructions instead, so
+ * they are meant for comparing commits, not for comparing with the board.
+ *
+ * 	Context switch	: block_task() called by the measuring task until the
+ * 					  spinning task runs again
+ * 	SysTick ISR		: kernel_tick() (kernel_stats.tick_isr_cycles)
+ * 	Wakeup latency	: SysTick reload until block_task() returns in the task
+ * 					  that was woken up by that tick
+ * 	Ringbuf			: One put and one get of a 16-byte sample, lock-free
+ * 					  (ringbuf.c) vs. the same ring buffer guarded by
+ * 					  DISABLE_INTERRUPTS() (Interrupts stay masked for most of it)
+ * 	Sem wake		: semaphore_give() by the spinning task until the task that
+ * 					  was waiting in semaphore_take() runs
+ * 	Notify wake		: Same with task_notify() and task_notify_wait()
+ * 	Sem direct		: One semaphore_give() and one semaphore_take() that does
+ * 					  not block, called directly (Privileged caller)
+ * 	Sem syscall		: The same pair through SVC (SYSCALL()), as an unprivileged
+ * 					  task calls them
+ * 	Pool alloc		: One mempool_alloc() and one mempool_free() of a 64-byte
+ * 					  block, with half of the pool in use
+ * 	Heap malloc		: One malloc() and one free() of 64 bytes (TLSF heap,
+ * 					  heap.c), with as many blocks allocated
+ *
+ * The tasks are privileged here (-DUNPRIVILEGED_TASKS=0) so that they can read
+ * SysTick; the system call path is taken explicitly.
+ *
+ * On the board, build with BENCH_DMA_LOAD=1 to keep DMA2 copying between two
+ * SRAM buffers for the whole run, and compare 'make bench' with
+ * 'make bench KERNEL_IN_CCM=0': With the TCBs and stacks in CCM RAM, the
+ * context switch and SysTick timings should not move under DMA load. (QEMU
+ * models neither the DMA nor the bus contention.)
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "kernel.h"
+#include "ringbuf.h"
+#include "sem.h"
+#include "svc.h"
+#include "mempool.h"
+
+#if !KERNEL_STATS || !CYCLE_COUNT_SYSTICK
+#error "bench.c must be built with -DKERNEL_STATS=1 -DCYCLE_COUNT_SYSTICK=1"
+#endif
+
+#define NUM_SAMPLES			1000U	/* Samples taken of each timing */
+#define NUM_LOAD_TASKS		8U		/* Sleeping tasks that keep the sleep queue busy */
+#define LOAD_PERIOD			50U		/* Shortest load task period (Ticks); load tasks
+									   spoil the context switch samples of the ticks
+									   they wake up at */
+#define NUM_RB_ELEMS		16U		/* Slots of the ring buffers */
+#define NUM_POOL_BLOCKS		32U		/* Blocks of the memory pool */
+#define POOL_BLOCK_SIZE		64U
+
+/* DMA load (DMA2 stream 0, memory-to-memory) */
+#ifndef BENCH_DMA_LOAD
+#define BENCH_DMA_LOAD		0U
+#endif
+#define DMA_LOAD_WORDS		4096U	/* Words per transfer (16 KiB) */
+#define RCC_AHB1ENR			(*(uint32_t volatile *)0x40023830U)
+#define DMA2EN				(1U << 22U)
+#define DMA2_LIFCR			(*(uint32_t volatile *)0x40026408U)
+#define DMA2_S0CR			(*(uint32_t volatile *)0x40026410U)
+#define DMA2_S0NDTR			(*(uint32_t volatile *)0x40026414U)
+#define DMA2_S0PAR			(*(uint32_t volatile *)0x40026418U)
+#define DMA2_S0M0AR			(*(uint32_t volatile *)0x4002641CU)
+#define DMA2_S0FCR			(*(uint32_t volatile *)0x40026424U)
+#define DMA_S0_FLAGS		0x3DU		/* All stream 0 flags in LISR/LIFCR */
+#define DMA_EN				(1U << 0U)
+#define DMA_TCIE			(1U << 4U)	/* Transfer complete interrupt */
+#define DMA_MEM_TO_MEM		(2U << 6U)
+#define DMA_PINC			(1U << 9U)
+#define DMA_MINC			(1U << 10U)
+#define DMA_WORDS			((2U << 11U) | (2U << 13U))	/* PSIZE, MSIZE */
+#define DMA_PL_VERY_HIGH	(3U << 16U)
+#define DMA_BURST4			((1U << 21U) | (1U << 23U))	/* PBURST, MBURST */
+#define DMA_FIFO_FULL		((1U << 2U) | (3U << 0U))		/* DMDIS, FTH */
+#define DMA2_STREAM0_IRQ	56U
+#define NVIC_ISER1			(*(uint32_t volatile *)0xE000E104U)
+#define NVIC_IPR_DMA2_S0	(*(uint8_t volatile *)(0xE000E400U + DMA2_STREAM0_IRQ))
+
+#define SPIN_PRIORITY		DEFAULT_PRIORITY
+#define LOAD_PRIORITY		(DEFAULT_PRIORITY + 1U)
+#define BENCH_PRIORITY		(DEFAULT_PRIORITY + 2U)
+
+/* What spin_handler() wakes bench_handler() with */
+#define WAKE_NONE			0U
+#define WAKE_SEMAPHORE		1U
+#define WAKE_NOTIFY			2U
+
+/* Minimum, maximum and average of a timing */
+typedef struct
+{
+	uint32_t min;
+	uint32_t max;
+	uint32_t sum;
+	uint32_t count;
+} bench_stat_t;
+
+/* Sensor sample moved through the ring buffers */
+typedef struct
+{
+	uint32_t data[4];
+} bench_sample_t;
+
+/* Function prototypes */
+void bench_handler(void *arg);		/* Measuring task */
+void spin_handler(void *arg);		/* Spinning task */
+void load_handler(void *arg);		/* Load tasks */
+#if BENCH_DMA_LOAD
+static void dma_load_start(void);
+#endif
+
+extern void initialise_monitor_handles(void);	/* Semihosting init function */
+
+bench_stat_t switch_stat;
+bench_stat_t tick_stat;
+bench_stat_t wakeup_stat;
+bench_stat_t rb_lockfree_stat;
+bench_stat_t rb_locked_stat;
+bench_stat_t sem_wake_stat;
+bench_stat_t notify_wake_stat;
+bench_stat_t sem_direct_stat;
+bench_stat_t sem_syscall_stat;
+bench_stat_t pool_stat;
+bench_stat_t heap_stat;
+
+TCB_t *bench_tcb;
+
+/* Lock-free ring buffer */
+ringbuf_t rb;
+bench_sample_t rb_storage[NUM_RB_ELEMS];
+
+/* Interrupt masking ring buffer, for comparison */
+bench_sample_t locked_storage[NUM_RB_ELEMS];
+uint32_t locked_head;
+uint32_t locked_tail;
+
+/* Given and taken back by bench_syscall() */
+semaphore_t syscall_sem;
+
+/* Memory pool, and the blocks bench_alloc() keeps allocated */
+MEMPOOL_DEFINE(bench_pool, POOL_BLOCK_SIZE, NUM_POOL_BLOCKS);
+void *held_blocks[NUM_POOL_BLOCKS / 2U];
+
+/* Handed from bench_handler() to spin_handler() for each context switch sample */
+volatile uint32_t switch_start;
+volatile uint32_t switch_tick;
+volatile uint32_t switch_armed;
+
+#if BENCH_DMA_LOAD
+/* Copied back and forth by DMA2 in the background */
+uint32_t dma_src[DMA_LOAD_WORDS];
+uint32_t dma_dst[DMA_LOAD_WORDS];
+#endif
+
+/* Handed from spin_handler() to bench_handler() for each wake sample */
+semaphore_t wake_sem;
+volatile uint32_t wake_mode;
+volatile uint32_t wake_start;
+volatile uint32_t wake_tick;
+
+int main(void)
+{
+	/* Initialize Semihosting for message printing feature */
+	initialise_monitor_handles();
+
+	printf("Benchmarking bare-metal RTOS\n");
+
+#if BENCH_DMA_LOAD
+	dma_load_start();
+	printf("DMA load on, kernel data in %s\n", KERNEL_IN_CCM ? "CCM RAM" : "SRAM");
+#endif
+
+	/* Create tasks */
+	task_create(spin_handler, NULL, SIZE_TASK_STACK, SPIN_PRIORITY);
+
+	for (uint32_t i = 0; i < NUM_LOAD_TASKS; i++)
+		task_create(load_handler, (void *)(uintptr_t)(LOAD_PERIOD + i), MIN_STACK_SIZE, LOAD_PRIORITY);
+
+	bench_tcb = task_create(bench_handler, NULL, SIZE_TASK_STACK, BENCH_PRIORITY);
+
+	/* Start kernel */
+	start_kernel();
+
+	/* Loop forever */
+	for(;;);
+} /* End of main */
+
+/*
+ * bench_record()
+ * Brief	: Adds a sample to a timing
+ * Param	: @stat - Timing to update
+ * 			: @cycles - Sample
+ * Retval	: None
+ * Note		: N/A
+ */
+static void bench_record(bench_stat_t *stat, uint32_t cycles)
+{
+	if ((stat->count == 0) || (cycles < stat->min))
+		stat->min = cycles;
+
+	if (cycles > stat->max)
+		stat->max = cycles;
+
+	stat->sum += cycles;
+	stat->count++;
+} /* End of bench_record */
+
+/*
+ * bench_print()
+ * Brief	: Prints a timing on one line
+ * Param	: @name - Name of the timing
+ * 			: @stat - Timing to print
+ * Retval	: None
+ * Note		: N/A
+ */
+static void bench_print(const char *name, bench_stat_t *stat)
+{
+	printf("%-16s: min %5lu  avg %5lu  max %5lu cycles (%lu samples)\n", name,
+		   (unsigned long)stat->min,
+		   (unsigned long)(stat->count ? (stat->sum / stat->count) : 0),
+		   (unsigned long)stat->max, (unsigned long)stat->count);
+} /* End of bench_print */
+
+/*
+ * locked_put()
+ * Brief	: Puts a sample into the interrupt masking ring buffer
+ * Param	: @sample - Sample to copy in
+ * Retval	: E_OK on success, E_FULL if there is no free slot
+ * Note		: N/A
+ */
+static int locked_put(const bench_sample_t *sample)
+{
+	DISABLE_INTERRUPTS();
+
+	if ((locked_head - locked_tail) >= NUM_RB_ELEMS)
+	{
+		ENABLE_INTERRUPTS();
+		return E_FULL;
+	}
+
+	locked_storage[locked_head % NUM_RB_ELEMS] = *sample;
+	locked_head++;
+
+	ENABLE_INTERRUPTS();
+
+	return E_OK;
+} /* End of locked_put */
+
+/*
+ * locked_get()
+ * Brief	: Gets a sample from the interrupt masking ring buffer
+ * Param	: @sample - Where to copy the sample to
+ * Retval	: E_OK on success, E_TIMEOUT if the ring buffer is empty
+ * Note		: N/A
+ */
+static int locked_get(bench_sample_t *sample)
+{
+	DISABLE_INTERRUPTS();
+
+	if (locked_head == locked_tail)
+	{
+		ENABLE_INTERRUPTS();
+		return E_TIMEOUT;
+	}
+
+	*sample = locked_storage[locked_tail % NUM_RB_ELEMS];
+	locked_tail++;
+
+	ENABLE_INTERRUPTS();
+
+	return E_OK;
+} /* End of locked_get */
+
+/*
+ * bench_ringbuf()
+ * Brief	: Times put/get pairs on both ring buffers
+ * Param	: None
+ * Retval	: None
+ * Note		: Samples that straddle a SysTick reload are dropped.
+ */
+static void bench_ringbuf(void)
+{
+	bench_sample_t in = { { 1U, 2U, 3U, 4U } };
+	bench_sample_t out;
+	uint32_t tick;
+	uint32_t start;
+	uint32_t end;
+
+	ringbuf_init(&rb, rb_storage, sizeof(bench_sample_t), NUM_RB_ELEMS);
+
+	for (uint32_t i = 0; i < NUM_SAMPLES; i++)
+	{
+		tick = get_tick_count();
+		start = SYSTICK_ELAPSED();
+		ringbuf_put(&rb, &in);
+		ringbuf_get(&rb, &out);
+		end = SYSTICK_ELAPSED();
+
+		if ((get_tick_count() == tick) && (end >= start))
+			bench_record(&rb_lockfree_stat, end - start);
+
+		tick = get_tick_count();
+		start = SYSTICK_ELAPSED();
+		locked_put(&in);
+		locked_get(&out);
+		end = SYSTICK_ELAPSED();
+
+		if ((get_tick_count() == tick) && (end >= start))
+			bench_record(&rb_locked_stat, end - start);
+	}
+} /* End of bench_ringbuf */
+
+/*
+ * bench_syscall()
+ * Brief	: Times a semaphore give/take pair called directly, then through
+ * 			  the system call interface
+ * Param	: None
+ * Retval	: None
+ * Note		: Neither call blocks, so the difference is the cost of the two
+ * 			  system calls. Samples that straddle a SysTick reload are dropped.
+ */
+static void bench_syscall(void)
+{
+	uint32_t tick;
+	uint32_t start;
+	uint32_t end;
+
+	semaphore_init(&syscall_sem, 0, SEM_BINARY, WAIT_FIFO);
+
+	for (uint32_t i = 0; i < NUM_SAMPLES; i++)
+	{
+		tick = get_tick_count();
+		start = SYSTICK_ELAPSED();
+		semaphore_give(&syscall_sem);
+		semaphore_take(&syscall_sem, NO_WAIT);
+		end = SYSTICK_ELAPSED();
+
+		if ((get_tick_count() == tick) && (end >= start))
+			bench_record(&sem_direct_stat, end - start);
+
+		tick = get_tick_count();
+		start = SYSTICK_ELAPSED();
+		SYSCALL(SYS_SEMAPHORE_GIVE, &syscall_sem, 0, 0, 0);
+		SYSCALL(SYS_SEMAPHORE_TAKE, &syscall_sem, NO_WAIT, 0, 0);
+		end = SYSTICK_ELAPSED();
+
+		if ((get_tick_count() == tick) && (end >= start))
+			bench_record(&sem_syscall_stat, end - start);
+	}
+} /* End of bench_syscall */
+
+/*
+ * bench_alloc()
+ * Brief	: Times allocating and freeing a block from a memory pool, then
+ * 			  from the newlib heap
+ * Param	: None
+ * Retval	: None
+ * Note		: Both start with the same number of blocks allocated.
+ */
+static void bench_alloc(void)
+{
+	uint32_t tick;
+	uint32_t start;
+	uint32_t end;
+	void *block;
+
+	mempool_init(&bench_pool, bench_pool_storage, POOL_BLOCK_SIZE, NUM_POOL_BLOCKS);
+
+	for (uint32_t i = 0; i < (NUM_POOL_BLOCKS / 2U); i++)
+		held_blocks[i] = mempool_alloc(&bench_pool);
+
+	for (uint32_t i = 0; i < NUM_SAMPLES; i++)
+	{
+		tick = get_tick_count();
+		start = SYSTICK_ELAPSED();
+		block = mempool_alloc(&bench_pool);
+		mempool_free(&bench_pool, block);
+		end = SYSTICK_ELAPSED();
+
+		if ((get_tick_count() == tick) && (end >= start))
+			bench_record(&pool_stat, end - start);
+	}
+
+	for (uint32_t i = 0; i < (NUM_POOL_BLOCKS / 2U); i++)
+		mempool_free(&bench_pool, held_blocks[i]);
+
+	for (uint32_t i = 0; i < (NUM_POOL_BLOCKS / 2U); i++)
+		held_blocks[i] = malloc(POOL_BLOCK_SIZE);
+
+	for (uint32_t i = 0; i < NUM_SAMPLES; i++)
+	{
+		tick = get_tick_count();
+		start = SYSTICK_ELAPSED();
+		block = malloc(POOL_BLOCK_SIZE);
+		free(block);
+		end = SYSTICK_ELAPSED();
+
+		if ((get_tick_count() == tick) && (end >= start))
+			bench_record(&heap_stat, end - start);
+	}
+
+	for (uint32_t i = 0; i < (NUM_POOL_BLOCKS / 2U); i++)
+		free(held_blocks[i]);
+} /* End of bench_alloc */
+
+/*
+ * bench_wake()
+ * Brief	: Times waking this task up with a semaphore, then with a direct
+ * 			  notification
+ * Param	: None
+ * Retval	: None
+ * Note		: spin_handler() gives or notifies whenever it runs, i.e. only
+ * 			  while this task waits.
+ */
+static void bench_wake(void)
+{
+	uint32_t end;
+
+	semaphore_init(&wake_sem, 0, SEM_BINARY, WAIT_FIFO);
+
+	wake_mode = WAKE_SEMAPHORE;
+
+	while (sem_wake_stat.count < NUM_SAMPLES)
+	{
+		semaphore_take(&wake_sem, WAIT_FOREVER);
+		end = SYSTICK_ELAPSED();
+
+		if ((get_tick_count() == wake_tick) && (end >= wake_start))
+			bench_record(&sem_wake_stat, end - wake_start);
+	}
+
+	wake_mode = WAKE_NOTIFY;
+
+	while (notify_wake_stat.count < NUM_SAMPLES)
+	{
+		task_notify_wait(0xFFFFFFFFU, NULL, WAIT_FOREVER);
+		end = SYSTICK_ELAPSED();
+
+		if ((get_tick_count() == wake_tick) && (end >= wake_start))
+			bench_record(&notify_wake_stat, end - wake_start);
+	}
+
+	wake_mode = WAKE_NONE;
+} /* End of bench_wake */
+
+/*
+ * bench_handler()
+ * Brief	: Takes the samples, prints the results and ends the run
+ * Param	: @arg - Unused
+ * Retval	: None
+ * Note		: Highest priority task; preempts spin_handler() on every wakeup.
+ */
+void bench_handler(void *arg)
+{
+	uint32_t elapsed;
+
+	bench_ringbuf();
+	bench_syscall();
+	bench_alloc();
+
+	/* Start on a tick boundary */
+	block_task(1);
+
+	while ((wakeup_stat.count < NUM_SAMPLES) || (switch_stat.count < NUM_SAMPLES))
+	{
+		/* Arm the context switch sample: spin_handler() completes it */
+		switch_tick = get_tick_count();
+		switch_start = SYSTICK_ELAPSED();
+		switch_armed = 1;
+
+		block_task(1);
+
+		/* Woken up by the tick that just reloaded SysTick */
+		elapsed = SYSTICK_ELAPSED();
+		bench_record(&wakeup_stat, elapsed);
+		bench_record(&tick_stat, kernel_stats.tick_isr_cycles);
+	}
+
+	bench_wake();
+
+	bench_print("Context switch", &switch_stat);
+	bench_print("SysTick ISR", &tick_stat);
+	bench_print("Wakeup latency", &wakeup_stat);
+	bench_print("Ringbuf lockfree", &rb_lockfree_stat);
+	bench_print("Ringbuf locked", &rb_locked_stat);
+	bench_print("Sem wake", &sem_wake_stat);
+	bench_print("Notify wake", &notify_wake_stat);
+	bench_print("Sem direct", &sem_direct_stat);
+	bench_print("Sem syscall", &sem_syscall_stat);
+	bench_print("Pool alloc", &pool_stat);
+	bench_print("Heap malloc", &heap_stat);
+	printf("SysTick ISR max  : %lu cycles\n", (unsigned long)kernel_stats.tick_isr_cycles_max);
+	printf("Bench stack used : %lu of %lu bytes\n", (unsigned long)task_stack_high_water(NULL),
+		   (unsigned long)bench_tcb->stack_size);
+
+	/* Semihosting SYS_EXIT; ends the QEMU run */
+	exit(0);
+} /* End of bench_handler */
+
+/*
+ * spin_handler()
+ * Brief	: Keeps the CPU busy, completes the context switch samples and
+ * 			  starts the wake samples
+ * Param	: @arg - Unused
+ * Retval	: None
+ * Note		: Keeps the idle task (and tickless idle) out of the measurements.
+ */
+void spin_handler(void *arg)
+{
+	uint32_t tick;
+	uint32_t now;
+
+	while (1)
+	{
+		if (switch_armed)
+		{
+			/* First thing after the switch (Or one loop iteration later) */
+			tick = get_tick_count();
+			now = SYSTICK_ELAPSED();
+			switch_armed = 0;
+
+			/* Drop the sample if SysTick reloaded in the meantime */
+			if ((tick == switch_tick) && (now >= switch_start))
+				bench_record(&switch_stat, now - switch_start);
+		}
+
+		if (wake_mode != WAKE_NONE)
+		{
+			wake_tick = get_tick_count();
+			wake_start = SYSTICK_ELAPSED();
+
+			if (wake_mode == WAKE_SEMAPHORE)
+				semaphore_give(&wake_sem);
+			else
+				task_notify(bench_tcb, 0, NOTIFY_GIVE);
+		}
+	}
+} /* End of spin_handler */
+
+/*
+ * load_handler()
+ * Brief	: Blocks for a task specific period forever
+ * Param	: @arg - Period in ticks
+ * Retval	: None
+ * Note		: N/A
+ */
+void load_handler(void *arg)
+{
+	uint32_t period = (uint32_t)(uintptr_t)arg;
+
+	while (1)
+	{
+		block_task(period);
+
+		/* Ran before spin_handler(): Spoils the pending context switch sample */
+		switch_armed = 0;
+	}
+} /* End of load_handler */
+
+#if BENCH_DMA_LOAD
+/*
+ * dma_load_start()
+ * Brief	: Starts DMA2 stream 0 copying dma_src[] to dma_dst[] at the highest
+ * 			  DMA priority, in 4-word bursts
+ * Param	: None
+ * Retval	: None
+ * Note		: DMA2_Stream0_IRQHandler() restarts it on completion, so the SRAM
+ * 			  bus stays loaded for the whole run.
+ */
+static void dma_load_start(void)
+{
+	RCC_AHB1ENR |= DMA2EN;
+
+	DMA2_S0CR = 0;
+	DMA2_LIFCR = DMA_S0_FLAGS;
+	DMA2_S0PAR = (uint32_t)dma_src;		/* Memory-to-memory: PAR is the source */
+	DMA2_S0M0AR = (uint32_t)dma_dst;
+	DMA2_S0NDTR = DMA_LOAD_WORDS;
+	DMA2_S0FCR = DMA_FIFO_FULL;
+	DMA2_S0CR = DMA_MEM_TO_MEM | DMA_PINC | DMA_MINC | DMA_WORDS | DMA_PL_VERY_HIGH |
+				DMA_BURST4 | DMA_TCIE;
+
+	/* Lowest priority; it does not use the kernel */
+	NVIC_IPR_DMA2_S0 = 0xF0U;
+	NVIC_ISER1 = (1U << (DMA2_STREAM0_IRQ - 32U));
+
+	DMA2_S0CR |= DMA_EN;
+} /* End of dma_load_start */
+
+/*
+ * DMA2_Stream0_IRQHandler()
+ * Brief	: Restarts the DMA load transfer
+ * Param	: None
+ * Retval	: None
+ * Note		: The stream disables itself on completion; NDTR reloads then.
+ */
+void DMA2_Stream0_IRQHandler(void)
+{
+	DMA2_LIFCR = DMA_S0_FLAGS;
+	DMA2_S0CR |= DMA_EN;
+} /* End of DMA2_Stream0_IRQHandler */
+#endif /* BENCH_DMA_LOAD */
@@ -0,0 +1,217 @@
+/*******************************************************************************
+ * File		: event.c
+ * Brief	: Implementation of event flag groups
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "event.h"
+#include "svc.h"
+
+/* Request of a task waiting on an event group (On its stack; wait_data) */
+typedef struct
+{
+	uint32_t bits;					/* Requested bits */
+	uint8_t options;				/* EVENT_WAIT_ANY/EVENT_WAIT_ALL, EVENT_CLEAR */
+	uint32_t flags;					/* Flags that satisfied the request */
+} event_request_t;
+
+/*
+ * event_satisfied()
+ * Brief	: Tells whether a set of flags satisfies a request
+ * Param	: @flags - Flag bits
+ * 			: @bits - Requested bits
+ * 			: @options - Wait options
+ * Retval	: 1 if satisfied, 0 otherwise
+ * Note		: N/A
+ */
+static int event_satisfied(uint32_t flags, uint32_t bits, uint8_t options)
+{
+	if (options & EVENT_WAIT_ALL)
+		return ((flags & bits) == bits);
+
+	return ((flags & bits) != 0);
+} /* End of event_satisfied */
+
+/*
+ * event_group_init()
+ * Brief	: Initializes an event group with all flags cleared
+ * Param	: @group - Event group to initialize
+ * Retval	: E_OK on success, E_INVALID if group is NULL
+ * Note		: Must not be called while the event group is in use.
+ */
+int event_group_init(event_group_t *group)
+{
+	if (group == NULL)
+		return E_INVALID;
+
+	group->flags = 0;
+	group->wait_queue.head = NULL;
+	group->wait_queue.order = WAIT_FIFO;
+
+	return E_OK;
+} /* End of event_group_init */
+
+/*
+ * event_group_wait()
+ * Brief	: Waits until any or all of the requested bits are set
+ * Param	: @group - Event group
+ * 			: @bits - Requested bits (Non-zero)
+ * 			: @options - EVENT_WAIT_ANY or EVENT_WAIT_ALL, optionally
+ * 						 '| EVENT_CLEAR' to clear the requested bits on exit
+ * 			: @flags - Where to store the flags as they were when the request
+ * 					   was satisfied (Or at the timeout); may be NULL
+ * 			: @timeout - Maximum number of ticks to wait (NO_WAIT: Do not wait,
+ * 						 WAIT_FOREVER: No limit)
+ * Retval	: E_OK if satisfied, E_TIMEOUT if not satisfied in time, E_INVALID
+ * 			  if bits is 0
+ * Note		: Tasks only, unless NO_WAIT is used.
+ */
+int event_group_wait(event_group_t *group, uint32_t bits, uint8_t options,
+					 uint32_t *flags, uint32_t timeout)
+{
+	event_request_t request;
+	int ret;
+
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL5(SYS_EVENT_GROUP_WAIT, group, bits, options, flags, timeout);
+
+	if (bits == 0)
+		return E_INVALID;
+
+	ENTER_CRITICAL();
+
+	if (event_satisfied(group->flags, bits, options))
+	{
+		if (flags != NULL)
+			*flags = group->flags;
+
+		if (options & EVENT_CLEAR)
+			group->flags &= ~bits;
+
+		EXIT_CRITICAL();
+		return E_OK;
+	}
+
+	if (timeout == NO_WAIT)
+	{
+		if (flags != NULL)
+			*flags = group->flags;
+
+		EXIT_CRITICAL();
+		return E_TIMEOUT;
+	}
+
+	request.bits = bits;
+	request.options = options;
+	curr_tcb->wait_data = &request;
+	kernel_wait(&group->wait_queue, timeout);
+
+	/* Switched out here, until satisfied by event_group_set() or timed out */
+	EXIT_CRITICAL();
+
+	ret = curr_tcb->wait_result;
+
+	if (flags != NULL)
+		*flags = (ret == E_OK) ? request.flags : group->flags;
+
+	return ret;
+} /* End of event_group_wait */
+
+/*
+ * event_group_set()
+ * Brief	: Sets flag bits and wakes up every task whose request is now
+ * 			  satisfied
+ * Param	: @group - Event group
+ * 			: @bits - Bits to set
+ * Retval	: E_OK
+ * Note		: Can be called from an ISR. All the waiters are checked against
+ * 			  the same flags in one pass, and the bits to clear on their exit
+ * 			  are cleared after the pass, so that two tasks waiting on the same
+ * 			  bit are both woken up. Then schedule() runs once.
+ */
+int event_group_set(event_group_t *group, uint32_t bits)
+{
+	event_request_t *request;
+	uint32_t clear_bits = 0;
+	TCB_t *tcb;
+	TCB_t *next;
+	TCB_t *last;
+
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_EVENT_GROUP_SET, group, bits, 0, 0);
+
+	ENTER_CRITICAL();
+
+	group->flags |= bits;
+
+	tcb = group->wait_queue.head;
+
+	if (tcb != NULL)
+	{
+		/* Waking a task unlinks it, but leaves its successor in place */
+		last = tcb->prev;
+
+		while (1)
+		{
+			next = tcb->next;
+			request = tcb->wait_data;
+
+			if (event_satisfied(group->flags, request->bits, request->options))
+			{
+				request->flags = group->flags;
+
+				if (request->options & EVENT_CLEAR)
+					clear_bits |= request->bits;
+
+				kernel_wake_task(tcb, E_OK);
+			}
+
+			if (tcb == last)
+				break;
+
+			tcb = next;
+		}
+
+		group->flags &= ~clear_bits;
+		schedule();
+	}
+
+	EXIT_CRITICAL();
+
+	return E_OK;
+} /* End of event_group_set */
+
+/*
+ * event_group_clear()
+ * Brief	: Clears flag bits
+ * Param	: @group - Event group
+ * 			: @bits - Bits to clear
+ * Retval	: E_OK
+ * Note		: Can be called from an ISR.
+ */
+int event_group_clear(event_group_t *group, uint32_t bits)
+{
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_EVENT_GROUP_CLEAR, group, bits, 0, 0);
+
+	ENTER_CRITICAL();
+	group->flags &= ~bits;
+	EXIT_CRITICAL();
+
+	return E_OK;
+} /* End of event_group_clear */
+
+/*
+ * event_group_get()
+ * Brief	: Returns the current flag bits
+ * Param	: @group - Event group
+ * Retval	: Flag bits
+ * Note		: N/A
+ */
+uint32_t event_group_get(event_group_t *group)
+{
+	return group->flags;
+} /* End of event_group_get */
@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * File		: event.h
+ * Brief	: Interface for event flag groups
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/* Wait options (Combined with '|') */
+#define EVENT_WAIT_ANY		0x00U	/* Satisfied by any of the requested bits */
+#define EVENT_WAIT_ALL		0x01U	/* Satisfied only by all of the requested bits */
+#define EVENT_CLEAR			0x02U	/* Clear the requested bits when satisfied */
+
+/* Event group of 32 flag bits; statically allocated by the application */
+typedef struct
+{
+	uint32_t flags;					/* Current flag bits */
+	wait_queue_t wait_queue;		/* Tasks blocked in event_group_wait() */
+} event_group_t;
+
+/* Event group interface */
+int event_group_init(event_group_t *group);
+int event_group_wait(event_group_t *group, uint32_t bits, uint8_t options,
+					 uint32_t *flags, uint32_t timeout);
+int event_group_set(event_group_t *group, uint32_t bits);
+int event_group_clear(event_group_t *group, uint32_t bits);
+uint32_t event_group_get(event_group_t *group);
+
+#endif /* event.h */
@@ -0,0 +1,815 @@
+/*******************************************************************************
+ * File		: heap.c
+ * Brief	: Implementation of the TLSF heap (Two-Level Segregated Fit)
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * Variable-sized allocations with a bounded execution time, from a dedicated
+ * region (HEAP_SIZE bytes in .heap) instead of _sbrk() growing towards the
+ * stack:
+ *
+ * 	- Free blocks are kept in segregated lists: The first level splits sizes by
+ * 	  power of two, the second level splits each power of two in HEAP_SL_COUNT
+ * 	  equal ranges. One bit per list in two bitmaps tells which lists are not
+ * 	  empty.
+ * 	- heap_alloc() rounds the request up to the next list boundary, so the
+ * 	  first block of any list found with two find-first-set operations is big
+ * 	  enough: O(1), no searching. The block is split if the rest is usable.
+ * 	- heap_free() merges the block with its free neighbours in memory (Each
+ * 	  block knows its size and whether the previous one is free): O(1).
+ *
+ * Every block is preceded by an 8-byte header (Its size and two flags); the
+ * address of the previous block is stored in the last word of that block,
+ * which is only needed while it is free. Blocks that can't hold a free list
+ * entry are never created.
+ *
+ * The heap is set up on its first use, so newlib can allocate before main().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "heap.h"
+#include "svc.h"
+
+#if HEAP_NEWLIB
+#include <stdlib.h>
+#include <errno.h>
+#include <reent.h>
+#endif
+
+/* Block header; a block starts one pointer before its header, in the block
+   that precedes it */
+typedef struct heap_block
+{
+	struct heap_block *prev_phys;	/* Previous block in memory (Valid only while it is free) */
+	uint32_t size;					/* Payload size | BLOCK_FREE | BLOCK_PREV_FREE */
+	uint32_t reserved;				/* Keeps the payload 8-byte aligned */
+	struct heap_block *next_free;	/* Free list links (While free); the payload starts here */
+	struct heap_block *prev_free;
+} heap_block_t;
+
+/* Flags in the low bits of heap_block_t size (Payload sizes are multiples of 8) */
+#define BLOCK_FREE			(1U << 0U)
+#define BLOCK_PREV_FREE		(1U << 1U)
+#define BLOCK_FLAGS			(BLOCK_FREE | BLOCK_PREV_FREE)
+
+/* Block layout */
+#define BLOCK_OFFSET		offsetof(heap_block_t, next_free)		/* Block to payload */
+#define BLOCK_OVERHEAD		(BLOCK_OFFSET - sizeof(heap_block_t *))	/* Header bytes between
+																	   two payloads */
+#define BLOCK_MIN_SIZE		HEAP_ROUND_UP(sizeof(heap_block_t) - BLOCK_OVERHEAD)
+
+#define HEAP_ROUND_UP(size)	(((size) + (HEAP_ALIGN - 1U)) & ~(HEAP_ALIGN - 1U))
+
+#define BLOCK_SIZE(block)	((block)->size & ~BLOCK_FLAGS)
+#define BLOCK_NEXT(block)	((heap_block_t *)((uint8_t *)(block) + BLOCK_OVERHEAD + BLOCK_SIZE(block)))
+#define BLOCK_PAYLOAD(block) ((void *)((uint8_t *)(block) + BLOCK_OFFSET))
+#define PAYLOAD_BLOCK(ptr)	((heap_block_t *)((uint8_t *)(ptr) - BLOCK_OFFSET))
+
+/* Sizes below HEAP_SMALL_SIZE all go to first-level list 0, in steps of
+   HEAP_ALIGN; above, first-level list n holds [2^(n + FL_SHIFT - 1), 2^(n + FL_SHIFT)) */
+#define HEAP_FL_SHIFT		(HEAP_SL_LOG2 + 3U)		/* log2(HEAP_ALIGN) = 3 */
+#define HEAP_SMALL_SIZE		(1U << HEAP_FL_SHIFT)
+#define HEAP_FL_COUNT		(HEAP_FL_MAX_LOG2 - HEAP_FL_SHIFT + 1U)
+
+_Static_assert(HEAP_SIZE <= (1U << HEAP_FL_MAX_LOG2), "HEAP_SIZE exceeds HEAP_FL_MAX_LOG2");
+
+/* Heap storage */
+static uint64_t heap_storage[HEAP_SIZE / sizeof(uint64_t)] SECTION(".heap");
+
+/* Segregated free lists and their bitmaps */
+static uint32_t fl_bitmap KERNEL_DATA;
+static uint32_t sl_bitmap[HEAP_FL_COUNT] KERNEL_DATA;
+static heap_block_t *free_lists[HEAP_FL_COUNT][HEAP_SL_COUNT] KERNEL_DATA;
+
+/* Statistics */
+static uint8_t heap_ready KERNEL_DATA;
+static uint32_t total_bytes KERNEL_DATA;
+static uint32_t free_bytes KERNEL_DATA;
+static uint32_t min_free_bytes KERNEL_DATA;
+static uint32_t num_free_blocks KERNEL_DATA;
+static uint32_t num_used_blocks KERNEL_DATA;
+static uint32_t num_fail KERNEL_DATA;
+
+/* newlib's own malloc lock guards the heap, so that anything in the C library
+   that takes it is serialized with heap_alloc() and heap_free() */
+#if HEAP_NEWLIB
+#define HEAP_LOCK()			__malloc_lock(_REENT)
+#define HEAP_UNLOCK()		__malloc_unlock(_REENT)
+void __malloc_lock(struct _reent *reent);
+void __malloc_unlock(struct _reent *reent);
+#else
+#define HEAP_LOCK()			ENTER_CRITICAL()
+#define HEAP_UNLOCK()		EXIT_CRITICAL()
+#endif
+
+/*
+ * heap_fls()
+ * Brief	: Finds the last (Most significant) bit set
+ * Param	: @word - Non-zero word
+ * Retval	: Bit number (0-31)
+ * Note		: A single CLZ instruction on the Cortex-M4
+ */
+static uint32_t heap_fls(uint32_t word)
+{
+	return 31U - (uint32_t)__builtin_clz(word);
+} /* End of heap_fls */
+
+/*
+ * heap_ffs()
+ * Brief	: Finds the first (Least significant) bit set
+ * Param	: @word - Non-zero word
+ * Retval	: Bit number (0-31)
+ * Note		: RBIT + CLZ on the Cortex-M4
+ */
+static uint32_t heap_ffs(uint32_t word)
+{
+	return (uint32_t)__builtin_ctz(word);
+} /* End of heap_ffs */
+
+/*
+ * mapping_insert()
+ * Brief	: Computes the free list a block of a given size belongs to
+ * Param	: @size - Payload size
+ * 			: @fl - First-level index
+ * 			: @sl - Second-level index
+ * Retval	: None
+ * Note		: N/A
+ */
+static void mapping_insert(uint32_t size, uint32_t *fl, uint32_t *sl)
+{
+	if (size < HEAP_SMALL_SIZE)
+	{
+		*fl = 0;
+		*sl = size / (HEAP_SMALL_SIZE / HEAP_SL_COUNT);
+	}
+	else
+	{
+		*fl = heap_fls(size);
+		*sl = (size >> (*fl - HEAP_SL_LOG2)) ^ HEAP_SL_COUNT;
+		*fl -= HEAP_FL_SHIFT - 1U;
+	}
+} /* End of mapping_insert */
+
+/*
+ * mapping_search()
+ * Brief	: Computes the first free list whose blocks are all big enough for a
+ * 			  given size
+ * Param	: @size - Requested payload size
+ * 			: @fl - First-level index (May be HEAP_FL_COUNT or more)
+ * 			: @sl - Second-level index
+ * Retval	: None
+ * Note		: N/A
+ */
+static void mapping_search(uint32_t size, uint32_t *fl, uint32_t *sl)
+{
+	if (size >= HEAP_SMALL_SIZE)
+		size += (1U << (heap_fls(size) - HEAP_SL_LOG2)) - 1U;
+
+	mapping_insert(size, fl, sl);
+} /* End of mapping_search */
+
+/*
+ * block_insert()
+ * Brief	: Adds a free block to its free list
+ * Param	: @block - Free block
+ * Retval	: None
+ * Note		: Must be called with the heap locked.
+ */
+static void block_insert(heap_block_t *block)
+{
+	uint32_t fl;
+	uint32_t sl;
+
+	mapping_insert(BLOCK_SIZE(block), &fl, &sl);
+
+	block->prev_free = NULL;
+	block->next_free = free_lists[fl][sl];
+
+	if (block->next_free != NULL)
+		block->next_free->prev_free = block;
+
+	free_lists[fl][sl] = block;
+	fl_bitmap |= (1U << fl);
+	sl_bitmap[fl] |= (1U << sl);
+
+	free_bytes += BLOCK_SIZE(block);
+	num_free_blocks++;
+} /* End of block_insert */
+
+/*
+ * block_remove()
+ * Brief	: Removes a free block from its free list
+ * Param	: @block - Free block
+ * Retval	: None
+ * Note		: Must be called with the heap locked.
+ */
+static void block_remove(heap_block_t *block)
+{
+	uint32_t fl;
+	uint32_t sl;
+
+	mapping_insert(BLOCK_SIZE(block), &fl, &sl);
+
+	if (block->next_free != NULL)
+		block->next_free->prev_free = block->prev_free;
+
+	if (block->prev_free != NULL)
+	{
+		block->prev_free->next_free = block->next_free;
+	}
+	else
+	{
+		free_lists[fl][sl] = block->next_free;
+
+		if (free_lists[fl][sl] == NULL)
+		{
+			sl_bitmap[fl] &= ~(1U << sl);
+
+			if (sl_bitmap[fl] == 0)
+				fl_bitmap &= ~(1U << fl);
+		}
+	}
+
+	free_bytes -= BLOCK_SIZE(block);
+	num_free_blocks--;
+} /* End of block_remove */
+
+/*
+ * block_trim()
+ * Brief	: Shrinks an allocated block and frees the rest of it
+ * Param	: @block - Allocated block
+ * 			: @size - Payload size to keep (Rounded, at least BLOCK_MIN_SIZE)
+ * Retval	: None
+ * Note		: Must be called with the heap locked. Nothing happens if the rest
+ * 			  would be too small to be a block. The rest is merged with the
+ * 			  next block if that one is free.
+ */
+static void block_trim(heap_block_t *block, uint32_t size)
+{
+	heap_block_t *rest;
+	heap_block_t *next;
+
+	if (BLOCK_SIZE(block) < (size + BLOCK_OVERHEAD + BLOCK_MIN_SIZE))
+		return;
+
+	rest = (heap_block_t *)((uint8_t *)block + BLOCK_OVERHEAD + size);
+	rest->size = BLOCK_SIZE(block) - size - BLOCK_OVERHEAD;
+	block->size = size | (block->size & BLOCK_FLAGS);
+
+	next = BLOCK_NEXT(rest);
+
+	if (next->size & BLOCK_FREE)
+	{
+		block_remove(next);
+		rest->size += BLOCK_OVERHEAD + BLOCK_SIZE(next);
+		next = BLOCK_NEXT(rest);
+	}
+
+	rest->size |= BLOCK_FREE;
+	next->prev_phys = rest;
+	next->size |= BLOCK_PREV_FREE;
+
+	block_insert(rest);
+} /* End of block_trim */
+
+/*
+ * heap_setup()
+ * Brief	: Turns the heap storage into a single free block
+ * Param	: None
+ * Retval	: None
+ * Note		: Must be called with the heap locked. The heap ends with an
+ * 			  allocated block of size 0, so that merging stops there.
+ */
+static void heap_setup(void)
+{
+	uint8_t *start = (uint8_t *)heap_storage;
+	uint8_t *payload = start + HEAP_ROUND_UP(BLOCK_OFFSET);
+	heap_block_t *block = PAYLOAD_BLOCK(payload);
+	heap_block_t *sentinel;
+
+	/* Leave room for a whole heap_block_t at the sentinel */
+	block->size = ((uint32_t)((start + HEAP_SIZE) - payload) -
+				   (sizeof(heap_block_t) - sizeof(heap_block_t *))) & ~(HEAP_ALIGN - 1U);
+
+	sentinel = BLOCK_NEXT(block);
+	sentinel->prev_phys = block;
+	sentinel->size = BLOCK_PREV_FREE;
+
+	block->size |= BLOCK_FREE;
+	block_insert(block);
+
+	total_bytes = free_bytes;
+	min_free_bytes = free_bytes;
+	heap_ready = 1;
+} /* End of heap_setup */
+
+/*
+ * heap_alloc_locked()
+ * Brief	: Allocates a block
+ * Param	: @size - Requested payload size
+ * Retval	: Allocated block, NULL if no free block is big enough
+ * Note		: Must be called with the heap locked.
+ */
+static heap_block_t *heap_alloc_locked(uint32_t size)
+{
+	heap_block_t *block;
+	uint32_t sl_map;
+	uint32_t fl;
+	uint32_t sl;
+
+	if (!heap_ready)
+		heap_setup();
+
+	mapping_search(size, &fl, &sl);
+
+	if (fl >= HEAP_FL_COUNT)
+		return NULL;
+
+	/* First non-empty list at (fl, sl) or above */
+	sl_map = sl_bitmap[fl] & (0xFFFFFFFFU << sl);
+
+	if (sl_map == 0)
+	{
+		if (((fl + 1U) >= HEAP_FL_COUNT) || ((fl_bitmap & (0xFFFFFFFFU << (fl + 1U))) == 0))
+			return NULL;
+
+		fl = heap_ffs(fl_bitmap & (0xFFFFFFFFU << (fl + 1U)));
+		sl_map = sl_bitmap[fl];
+	}
+
+	sl = heap_ffs(sl_map);
+	block = free_lists[fl][sl];
+
+	block_remove(block);
+	block->size &= ~BLOCK_FREE;
+	BLOCK_NEXT(block)->size &= ~BLOCK_PREV_FREE;
+
+	block_trim(block, size);
+
+	num_used_blocks++;
+
+	if (free_bytes < min_free_bytes)
+		min_free_bytes = free_bytes;
+
+	return block;
+} /* End of heap_alloc_locked */
+
+/*
+ * heap_free_locked()
+ * Brief	: Frees a block and merges it with its free neighbours
+ * Param	: @block - Allocated block
+ * Retval	: None
+ * Note		: Must be called with the heap locked. The header of the block is
+ * 			  marked free even if it is merged into the previous block, so a
+ * 			  second heap_free() of it is ignored.
+ */
+static void heap_free_locked(heap_block_t *block)
+{
+	heap_block_t *next;
+	heap_block_t *prev;
+
+	block->size |= BLOCK_FREE;
+
+	if (block->size & BLOCK_PREV_FREE)
+	{
+		prev = block->prev_phys;
+		block_remove(prev);
+		prev->size += BLOCK_OVERHEAD + BLOCK_SIZE(block);
+		block = prev;
+	}
+
+	next = BLOCK_NEXT(block);
+
+	if (next->size & BLOCK_FREE)
+	{
+		block_remove(next);
+		block->size += BLOCK_OVERHEAD + BLOCK_SIZE(next);
+		next = BLOCK_NEXT(block);
+	}
+
+	block->size |= BLOCK_FREE;
+	next->prev_phys = block;
+	next->size |= BLOCK_PREV_FREE;
+
+	block_insert(block);
+
+	num_used_blocks--;
+} /* End of heap_free_locked */
+
+/*
+ * heap_adjust_size()
+ * Brief	: Converts a requested size to a block payload size
+ * Param	: @size - Requested size in bytes
+ * Retval	: Payload size, 0 if the request is too large for any block
+ * Note		: N/A
+ */
+static uint32_t heap_adjust_size(uint32_t size)
+{
+	if (size > (1U << HEAP_FL_MAX_LOG2))
+		return 0;
+
+	size = HEAP_ROUND_UP(size);
+
+	return (size < BLOCK_MIN_SIZE) ? BLOCK_MIN_SIZE : size;
+} /* End of heap_adjust_size */
+
+/*
+ * heap_owns()
+ * Brief	: Tells whether a pointer was returned by heap_alloc()
+ * Param	: @ptr - Pointer to check
+ * Retval	: 1 if ptr is the payload of an allocated block, 0 otherwise
+ * Note		: Catches frees of foreign pointers and double frees, as long
+ * 			  as the header has not been overwritten.
+ */
+static int heap_owns(void *ptr)
+{
+	uint8_t *addr = (uint8_t *)ptr;
+
+	if ((addr < (uint8_t *)heap_storage) || (addr >= ((uint8_t *)heap_storage + HEAP_SIZE)) ||
+		(((uintptr_t)addr & (HEAP_ALIGN - 1U)) != 0))
+		return 0;
+
+	return !(PAYLOAD_BLOCK(ptr)->size & BLOCK_FREE);
+} /* End of heap_owns */
+
+/*
+ * heap_alloc()
+ * Brief	: Allocates memory from the heap
+ * Param	: @size - Number of bytes
+ * Retval	: Pointer to 8-byte aligned memory, NULL if the request can't be met
+ * Note		: O(1); never blocks. Can be called from an ISR. The memory is not
+ * 			  cleared (See heap_calloc()).
+ */
+void *heap_alloc(uint32_t size)
+{
+	heap_block_t *block = NULL;
+
+	if (!IS_PRIVILEGED())
+		return (void *)SYSCALL(SYS_HEAP_ALLOC, size, 0, 0, 0);
+
+	size = heap_adjust_size(size);
+
+	HEAP_LOCK();
+
+	if (size != 0)
+		block = heap_alloc_locked(size);
+
+	if (block == NULL)
+	{
+		num_fail++;
+		HEAP_UNLOCK();
+		return NULL;
+	}
+
+	HEAP_UNLOCK();
+
+	return BLOCK_PAYLOAD(block);
+} /* End of heap_alloc */
+
+/*
+ * heap_free()
+ * Brief	: Returns memory to the heap
+ * Param	: @ptr - Pointer returned by heap_alloc(), heap_calloc() or
+ * 				 heap_realloc() (NULL: Nothing is done)
+ * Retval	: None
+ * Note		: O(1); never blocks. Can be called from an ISR. Pointers that do
+ * 			  not belong to an allocated block are ignored.
+ */
+void heap_free(void *ptr)
+{
+	if (!IS_PRIVILEGED())
+	{
+		(void)SYSCALL(SYS_HEAP_FREE, ptr, 0, 0, 0);
+		return;
+	}
+
+	if (ptr == NULL)
+		return;
+
+	HEAP_LOCK();
+
+	if (heap_owns(ptr))
+		heap_free_locked(PAYLOAD_BLOCK(ptr));
+
+	HEAP_UNLOCK();
+} /* End of heap_free */
+
+/*
+ * heap_realloc()
+ * Brief	: Resizes an allocation, moving it if needed
+ * Param	: @ptr - Pointer returned by heap_alloc() (NULL: Same as
+ * 				 heap_alloc())
+ * 			: @size - New number of bytes (0: Same as heap_free())
+ * Retval	: Pointer to the resized memory, NULL if it can't be resized (ptr
+ * 			  then stays valid)
+ * Note		: Shrinking, or growing into a free block that follows, is O(1)
+ * 			  and keeps the address. Otherwise the content is copied to a new
+ * 			  block, outside the critical section.
+ */
+void *heap_realloc(void *ptr, uint32_t size)
+{
+	heap_block_t *block;
+	heap_block_t *next;
+	void *new_ptr;
+	uint32_t adjusted;
+
+	if (!IS_PRIVILEGED())
+		return (void *)SYSCALL(SYS_HEAP_REALLOC, ptr, size, 0, 0);
+
+	if (ptr == NULL)
+		return heap_alloc(size);
+
+	if (size == 0)
+	{
+		heap_free(ptr);
+		return NULL;
+	}
+
+	adjusted = heap_adjust_size(size);
+
+	HEAP_LOCK();
+
+	if ((adjusted == 0) || !heap_owns(ptr))
+	{
+		num_fail++;
+		HEAP_UNLOCK();
+		return NULL;
+	}
+
+	block = PAYLOAD_BLOCK(ptr);
+	next = BLOCK_NEXT(block);
+
+	/* Grow into the next block if it is free and big enough */
+	if ((adjusted > BLOCK_SIZE(block)) && (next->size & BLOCK_FREE) &&
+		((BLOCK_SIZE(block) + BLOCK_OVERHEAD + BLOCK_SIZE(next)) >= adjusted))
+	{
+		block_remove(next);
+		block->size += BLOCK_OVERHEAD + BLOCK_SIZE(next);
+		BLOCK_NEXT(block)->size &= ~BLOCK_PREV_FREE;
+	}
+
+	if (adjusted <= BLOCK_SIZE(block))
+	{
+		block_trim(block, adjusted);
+
+		if (free_bytes < min_free_bytes)
+			min_free_bytes = free_bytes;
+
+		HEAP_UNLOCK();
+		return ptr;
+	}
+
+	HEAP_UNLOCK();
+
+	new_ptr = heap_alloc(size);
+
+	if (new_ptr != NULL)
+	{
+		/* Both blocks belong to the caller: No need to lock the heap */
+		memcpy(new_ptr, ptr, BLOCK_SIZE(block));
+		heap_free(ptr);
+	}
+
+	return new_ptr;
+} /* End of heap_realloc */
+
+/*
+ * heap_calloc()
+ * Brief	: Allocates cleared memory for an array
+ * Param	: @num - Number of elements
+ * 			: @size - Bytes per element
+ * Retval	: Pointer to the memory, NULL if the request can't be met
+ * Note		: The clearing is O(size), but done outside the critical section.
+ */
+void *heap_calloc(uint32_t num, uint32_t size)
+{
+	void *ptr;
+
+	if ((size != 0) && (num > (0xFFFFFFFFU / size)))
+		return NULL;
+
+	ptr = heap_alloc(num * size);
+
+	if (ptr != NULL)
+		memset(ptr, 0, num * size);
+
+	return ptr;
+} /* End of heap_calloc */
+
+/*
+ * heap_get_stats()
+ * Brief	: Reads the heap usage and fragmentation
+ * Param	: @stats - Where to copy the statistics to
+ * Retval	: None
+ * Note		: The largest free block is looked up in the highest non-empty
+ * 			  free list only, so this is cheap but not O(1).
+ */
+void heap_get_stats(heap_stats_t *stats)
+{
+	heap_block_t *block;
+	uint32_t largest = 0;
+	uint32_t fl;
+
+	if (!IS_PRIVILEGED())
+	{
+		(void)SYSCALL(SYS_HEAP_GET_STATS, stats, 0, 0, 0);
+		return;
+	}
+
+	HEAP_LOCK();
+
+	if (!heap_ready)
+		heap_setup();
+
+	if (fl_bitmap != 0)
+	{
+		fl = heap_fls(fl_bitmap);
+
+		for (block = free_lists[fl][heap_fls(sl_bitmap[fl])]; block != NULL; block = block->next_free)
+		{
+			if (BLOCK_SIZE(block) > largest)
+				largest = BLOCK_SIZE(block);
+		}
+	}
+
+	stats->total_bytes = total_bytes;
+	stats->free_bytes = free_bytes;
+	stats->min_free_bytes = min_free_bytes;
+	stats->largest_free = largest;
+	stats->num_free_blocks = num_free_blocks;
+	stats->num_used_blocks = num_used_blocks;
+	stats->num_fail = num_fail;
+	stats->fragmentation = (free_bytes != 0) ?
+						   (uint32_t)(((uint64_t)(free_bytes - largest) * 100U) / free_bytes) : 0;
+
+	HEAP_UNLOCK();
+} /* End of heap_get_stats */
+
+#if HEAP_NEWLIB
+/*
+ * newlib glue: The C library (printf() included) allocates through the
+ * reentrant _malloc_r() family, and the application through malloc(); both
+ * are defined here, so newlib's own allocator is not linked in and nothing
+ * grows the _sbrk() heap any more. Whether the linker really takes these
+ * instead of the library's (--specs=nano.specs) is checked by the makefile in
+ * final.map after every link.
+ */
+
+/*
+ * __malloc_lock()
+ * Brief	: Locks the heap (Called by newlib, and by this file)
+ * Param	: @reent - Reentrancy structure of the caller (Unused)
+ * Retval	: None
+ * Note		: A kernel critical section, which nests like newlib expects. The
+ * 			  heap operations are bounded, so it is held only briefly.
+ * 			  BASEPRI does not mask the SVC handler, the fault handlers or the
+ * 			  ISRs above KERNEL_INTERRUPT_PRIORITY: They must not allocate.
+ * 			  Unprivileged tasks reach the heap through system calls, so the
+ * 			  lock is only taken in privileged code.
+ */
+void __malloc_lock(struct _reent *reent)
+{
+	(void)reent;
+
+	ENTER_CRITICAL();
+} /* End of __malloc_lock */
+
+/*
+ * __malloc_unlock()
+ * Brief	: Unlocks the heap
+ * Param	: @reent - Reentrancy structure of the caller (Unused)
+ * Retval	: None
+ * Note		: N/A
+ */
+void __malloc_unlock(struct _reent *reent)
+{
+	(void)reent;
+
+	EXIT_CRITICAL();
+} /* End of __malloc_unlock */
+
+/*
+ * _malloc_r()
+ * Brief	: heap_alloc() for newlib
+ * Param	: @reent - Reentrancy structure of the caller (errno)
+ * 			: @size - Number of bytes
+ * Retval	: Pointer to the memory, NULL (ENOMEM) on failure
+ * Note		: N/A
+ */
+void *_malloc_r(struct _reent *reent, size_t size)
+{
+	void *ptr = heap_alloc(size);
+
+	if (ptr == NULL)
+		reent->_errno = ENOMEM;
+
+	return ptr;
+} /* End of _malloc_r */
+
+/*
+ * _free_r()
+ * Brief	: heap_free() for newlib
+ * Param	: @reent - Reentrancy structure of the caller (Unused)
+ * 			: @ptr - Memory to free
+ * Retval	: None
+ * Note		: N/A
+ */
+void _free_r(struct _reent *reent, void *ptr)
+{
+	(void)reent;
+
+	heap_free(ptr);
+} /* End of _free_r */
+
+/*
+ * _calloc_r()
+ * Brief	: heap_calloc() for newlib
+ * Param	: @reent - Reentrancy structure of the caller (errno)
+ * 			: @num - Number of elements
+ * 			: @size - Bytes per element
+ * Retval	: Pointer to the memory, NULL (ENOMEM) on failure
+ * Note		: N/A
+ */
+void *_calloc_r(struct _reent *reent, size_t num, size_t size)
+{
+	void *ptr = heap_calloc(num, size);
+
+	if (ptr == NULL)
+		reent->_errno = ENOMEM;
+
+	return ptr;
+} /* End of _calloc_r */
+
+/*
+ * _realloc_r()
+ * Brief	: heap_realloc() for newlib
+ * Param	: @reent - Reentrancy structure of the caller (errno)
+ * 			: @ptr - Memory to resize
+ * 			: @size - New number of bytes
+ * Retval	: Pointer to the memory, NULL (ENOMEM) on failure
+ * Note		: N/A
+ */
+void *_realloc_r(struct _reent *reent, void *ptr, size_t size)
+{
+	void *new_ptr = heap_realloc(ptr, size);
+
+	if ((new_ptr == NULL) && (size != 0))
+		reent->_errno = ENOMEM;
+
+	return new_ptr;
+} /* End of _realloc_r */
+
+/*
+ * malloc()
+ * Brief	: Allocates memory (C library)
+ * Param	: @size - Number of bytes
+ * Retval	: Pointer to the memory, NULL on failure
+ * Note		: N/A
+ */
+void *malloc(size_t size)
+{
+	return _malloc_r(_REENT, size);
+} /* End of malloc */
+
+/*
+ * free()
+ * Brief	: Frees memory (C library)
+ * Param	: @ptr - Memory to free
+ * Retval	: None
+ * Note		: N/A
+ */
+void free(void *ptr)
+{
+	_free_r(_REENT, ptr);
+} /* End of free */
+
+/*
+ * calloc()
+ * Brief	: Allocates cleared memory (C library)
+ * Param	: @num - Number of elements
+ * 			: @size - Bytes per element
+ * Retval	: Pointer to the memory, NULL on failure
+ * Note		: N/A
+ */
+void *calloc(size_t num, size_t size)
+{
+	return _calloc_r(_REENT, num, size);
+} /* End of calloc */
+
+/*
+ * realloc()
+ * Brief	: Resizes memory (C library)
+ * Param	: @ptr - Memory to resize
+ * 			: @size - New number of bytes
+ * Retval	: Pointer to the memory, NULL on failure
+ * Note		: N/A
+ */
+void *realloc(void *ptr, size_t size)
+{
+	return _realloc_r(_REENT, ptr, size);
+} /* End of realloc */
+#endif /* HEAP_NEWLIB */
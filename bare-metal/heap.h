@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * File		: heap.h
+ * Brief	: Interface for the TLSF heap (Two-Level Segregated Fit)
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/* Heap storage, in the .heap section of stm32_ls.ld */
+#ifndef HEAP_SIZE
+#define HEAP_SIZE			(16U * 1024U)
+#endif
+
+/* Largest block the heap can manage is (1 << HEAP_FL_MAX_LOG2) bytes; each
+   power of two below it costs HEAP_SL_COUNT list heads */
+#ifndef HEAP_FL_MAX_LOG2
+#define HEAP_FL_MAX_LOG2	17U		/* 128 KiB: All of SRAM */
+#endif
+
+/* Second-level lists per power of two: A free block is found in O(1) among
+   blocks that are at most 1/HEAP_SL_COUNT larger than the request */
+#define HEAP_SL_LOG2		4U
+#define HEAP_SL_COUNT		(1U << HEAP_SL_LOG2)
+
+/* Every allocation is 8-byte aligned, like newlib's malloc() */
+#define HEAP_ALIGN			8U
+
+/* Route newlib's malloc(), free(), calloc() and realloc() to this heap, and
+   provide its __malloc_lock()/__malloc_unlock() (Ports may turn it off).
+   The lock is a kernel critical section, so neither the heap functions nor
+   anything in the C library that may allocate (printf() on a stream without a
+   buffer yet, for one) may be called from the SVC handler, from a fault
+   handler, or from an ISR above KERNEL_INTERRUPT_PRIORITY: The critical
+   section does not mask them, and they would break into a heap operation
+   that is half done. 'make' checks in the link map that newlib was linked
+   against heap.o (HEAP_GLUE_SYMS). */
+#ifndef HEAP_NEWLIB
+#define HEAP_NEWLIB			1U
+#endif
+
+/* Heap statistics (heap_get_stats()) */
+typedef struct
+{
+	uint32_t total_bytes;			/* Bytes available for allocations, right after startup */
+	uint32_t free_bytes;			/* Bytes in free blocks now */
+	uint32_t min_free_bytes;		/* Lowest free_bytes so far (High-water mark) */
+	uint32_t largest_free;			/* Largest free block */
+	uint32_t num_free_blocks;		/* Free blocks */
+	uint32_t num_used_blocks;		/* Allocated blocks */
+	uint32_t num_fail;				/* Allocations that failed */
+	uint32_t fragmentation;			/* Percentage of free_bytes that is not in the largest
+									   free block (0: Not fragmented) */
+} heap_stats_t;
+
+/* Heap interface */
+void *heap_alloc(uint32_t size);
+void heap_free(void *ptr);
+void *heap_realloc(void *ptr, uint32_t size);
+void *heap_calloc(uint32_t num, uint32_t size);
+void heap_get_stats(heap_stats_t *stats);
+
+#endif /* heap.h */
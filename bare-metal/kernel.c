@@ -8,445 +8,1031 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "kernel.h"
-#include "led.h"
+#include "svc.h"
+
+/* Global variables (KERNEL_DATA: Unprivileged tasks can't access them directly,
+   nor any of the other kernel state below) */
+TCB_t *curr_tcb KERNEL_DATA;	/* TCB of the task currently running on the CPU */
+TCB_t *next_tcb KERNEL_DATA;	/* TCB of the task PendSV_Handler() is to switch to */
+uint32_t global_tick_count KERNEL_DATA;
+
+/* TCB pool; tcbs[IDLE_TASK] is reserved for the idle task */
+TCB_t tcbs[MAX_TASKS] KERNEL_DATA;
+uint32_t num_tasks KERNEL_DATA;	/* Number of TCBs handed out by task_create() (The
+								   idle task's not included) */
+
+/* Stack pool that task stacks are carved from (8-byte aligned as per AAPCS) */
+uint64_t stack_pool[SIZE_STACK_POOL / sizeof(uint64_t)] KERNEL_DATA;
+uint32_t stack_pool_used KERNEL_DATA;	/* Bytes handed out so far */
+
+/* Ready structure: One circular doubly-linked list of READY tasks per priority
+   level, plus a bitmap whose bit n is set iff ready_list[n] is non-empty. The
+   highest ready priority is then found with a single CLZ instruction. */
+TCB_t *ready_list[NUM_PRIORITIES] KERNEL_DATA;
+uint32_t ready_bitmap KERNEL_DATA;
+
+/* Sleep queue: BLOCKED tasks sorted by their wakeup tick (block_count), the
+   earliest deadline first. The tick handler only ever looks at its head. */
+TCB_t *sleep_queue KERNEL_DATA;
+
+#if KERNEL_STATS
+/* Kernel statistics (Cycle counts) */
+kernel_stats_t kernel_stats KERNEL_DATA;
+#endif
+
+#if SCHED_EDF
+/* 
+ * edf_runs_before()
+ * Brief	: Tells whether a READY task goes ahead of another one under EDF
+ * Param	: @a - TCB of a task in the ready list
+ * 			: @b - TCB of the task being inserted
+ * Retval	: 1 if b has no deadline, or if a has a deadline that is no later
+ * 			  than b's; 0 otherwise
+ * Note		: Deadlines are compared as signed differences (Wrap-safe). A task
+ * 			  without a deadline goes after every task, including the other
+ * 			  ones without a deadline (Round-robin among them).
+ */
+int edf_runs_before(TCB_t *a, TCB_t *b)
+{
+	if (b->deadline == NO_DEADLINE)
+		return 1;
+
+	if (a->deadline == NO_DEADLINE)
+		return 0;
 
-/* Global variables */
-uint8_t curr_task = 1;	/* Denotes the current task running on the CPU (Initialize to Task 1) */
-uint32_t global_tick_count;
+	return ((int32_t)(a->abs_deadline - b->abs_deadline) <= 0);
+} /* End of edf_runs_before */
 
-/* Structure for Task Control Blocks (TCBs) */
-typedef struct
+#endif /* SCHED_EDF */
+
+/* 
+ * ready_list_insert()
+ * Brief	: Appends a task to the tail of the ready list of its priority
+ * 			  (SCHED_EDF: Inserts it in deadline order)
+ * Param	: @tcb - TCB of the task to be made schedulable
+ * Retval	: None
+ * Note		: Must be called in a critical section (or from an exception
+ * 			  handler). Under SCHED_EDF, a task goes after every task whose
+ * 			  deadline is no later than its own, so the head of the level has
+ * 			  the nearest deadline and equal deadlines are served FIFO. Tasks
+ * 			  without a deadline always go to the tail.
+ */
+void ready_list_insert(TCB_t *tcb)
 {
-	uint32_t psp;					/* Task stack pointer */
-	uint32_t block_count;			/* How long it should block */
-	uint8_t state;					/* Task state */
-	void (*task_handler)(void);		/* Function pointer to task handler */
-} TCB_t;
+	TCB_t *head = ready_list[tcb->priority];
+	TCB_t *node;
 
-/* Array to manage task control block handles */
-TCB_t tcbs[NUM_TASKS];
+	if (head == NULL)
+	{
+		/* First task at this level; it forms a list of its own */
+		tcb->next = tcb;
+		tcb->prev = tcb;
+		ready_list[tcb->priority] = tcb;
+		ready_bitmap |= (1U << tcb->priority);
+	}
+	else
+	{
+		/* Insert in front of node; the head by default, since the tail of a
+		   circular list is the predecessor of its head */
+		node = head;
+
+#if SCHED_EDF
+		/* O(n) in the number of READY tasks at this level, like the sleep
+		   queue insertion */
+		while (edf_runs_before(node, tcb))
+		{
+			node = node->next;
+
+			if (node == head)
+				break;
+		}
+#endif
+
+		tcb->next = node;
+		tcb->prev = node->prev;
+		node->prev->next = tcb;
+		node->prev = tcb;
+
+#if SCHED_EDF
+		/* Nearest deadline of the level: Only a deadline strictly earlier
+		   than the head's (or the first one of the level) takes its place */
+		if (!edf_runs_before(head, tcb))
+			ready_list[tcb->priority] = tcb;
+#endif
+	}
+} /* End of ready_list_insert */
 
 /* 
- * Idle task handler()
- * Brief	: Idle task handler
- * Param	: None
+ * ready_list_remove()
+ * Brief	: Removes a task from the ready list of its priority
+ * Param	: @tcb - TCB of the task to be made unschedulable
  * Retval	: None
- * Note		: Idle task will run only when all other user tasks are in BLOCKED
- * 			  state.
+ * Note		: Must be called in a critical section (or from an exception
+ * 			  handler).
  */
-void idle_task_handler(void)
+void ready_list_remove(TCB_t *tcb)
 {
-	while (1);
-} /* End of idle_task_handler */
+	if (tcb->next == tcb)
+	{
+		/* Last task at this level */
+		ready_list[tcb->priority] = NULL;
+		ready_bitmap &= ~(1U << tcb->priority);
+	}
+	else
+	{
+		tcb->prev->next = tcb->next;
+		tcb->next->prev = tcb->prev;
+
+		if (ready_list[tcb->priority] == tcb)
+			ready_list[tcb->priority] = tcb->next;
+	}
+
+	tcb->next = NULL;
+	tcb->prev = NULL;
+} /* End of ready_list_remove */
 
 /* 
- * schedule()
- * Brief	: Triggers context switching by setting the PendSV exception
- * Param	: None
+ * sleep_queue_insert()
+ * Brief	: Inserts a task into the sleep queue, ordered by its wakeup tick
+ * Param	: @tcb - TCB of the task whose block_count has been set
  * Retval	: None
- * Note		: N/A
+ * Note		: Must be called in a critical section. Deadlines are compared
+ * 			  as signed differences, so the order stays correct across
+ * 			  global_tick_count wrap. Tasks with the same deadline are woken in
+ * 			  the order they went to sleep.
  */
-void schedule(void)
+void sleep_queue_insert(TCB_t *tcb)
 {
-	/* Pend the PendSV exception */
-	ICSR |= PENDSVSET;
-} /* End of schedule */
+	TCB_t *prev = NULL;
+	TCB_t *node = sleep_queue;
+
+	/* Skip over every task that is due no later than this one */
+	while ((node != NULL) && ((int32_t)(node->block_count - tcb->block_count) <= 0))
+	{
+		prev = node;
+		node = node->sleep_next;
+	}
+
+	tcb->sleep_prev = prev;
+	tcb->sleep_next = node;
+
+	if (node != NULL)
+		node->sleep_prev = tcb;
+
+	if (prev != NULL)
+		prev->sleep_next = tcb;
+	else
+		sleep_queue = tcb;
+} /* End of sleep_queue_insert */
 
 /* 
- * block_task()
- * Brief	: Blocks the task that calls this function for tick_count ticks 
- * Param	: None
+ * sleep_queue_remove()
+ * Brief	: Removes a task from the sleep queue
+ * Param	: @tcb - TCB of a task in the sleep queue
  * Retval	: None
- * Note		: N/A
+ * Note		: Must be called in a critical section.
  */
-void block_task(uint32_t tick_count)
+void sleep_queue_remove(TCB_t *tcb)
+{
+	if (tcb->sleep_next != NULL)
+		tcb->sleep_next->sleep_prev = tcb->sleep_prev;
+
+	if (tcb->sleep_prev != NULL)
+		tcb->sleep_prev->sleep_next = tcb->sleep_next;
+	else
+		sleep_queue = tcb->sleep_next;
+
+	tcb->sleep_next = NULL;
+	tcb->sleep_prev = NULL;
+} /* End of sleep_queue_remove */
+
+/* 
+ * wait_queue_insert()
+ * Brief	: Adds a task to the wait queue of a kernel object
+ * Param	: @wait_queue - Wait queue of the object
+ * 			: @tcb - TCB of the task to wait (Not in the ready list)
+ * Retval	: None
+ * Note		: Must be called in a critical section. WAIT_FIFO appends to the
+ * 			  tail; WAIT_PRIORITY goes after every waiter of the same or higher
+ * 			  priority.
+ */
+void wait_queue_insert(wait_queue_t *wait_queue, TCB_t *tcb)
 {
-	/* To prevent race condition on global variables, make sure to globally 
-	   disable interrupt */
-	DISABLE_INTERRUPTS();
-		/* Now, until ENABLE_INTERRUPT, only Thread mode code will run. */
+	TCB_t *head = wait_queue->head;
+	TCB_t *node;
+
+	tcb->wait_queue = wait_queue;
 
-	/* Do not allow changing the idle task state to BLOCKED. */
-	if (curr_task == 0)
+	if (head == NULL)
+	{
+		tcb->next = tcb;
+		tcb->prev = tcb;
+		wait_queue->head = tcb;
 		return;
+	}
 
-	/* Store in the block_count the timestamp to unblock the task */
-	tcbs[curr_task].block_count = global_tick_count + tick_count;
+	/* Insert in front of node; the head by default, i.e. at the tail */
+	node = head;
 
-	/* Switch task state to BLOCKED */
-	tcbs[curr_task].state = BLOCKED;
+	if (wait_queue->order == WAIT_PRIORITY)
+	{
+		while (node->priority >= tcb->priority)
+		{
+			node = node->next;
 
-	/* Allow other task to run */
-	schedule();
+			if (node == head)
+				break;
+		}
+	}
 
-	/* Globally enable interrupt */
-	ENABLE_INTERRUPTS();
-} /* End of block_task */
+	tcb->next = node;
+	tcb->prev = node->prev;
+	node->prev->next = tcb;
+	node->prev = tcb;
 
-/*
- * init_systick_timer()
- * Brief	: Initializes SysTick Timer
- * Param	: @tick_hz
+	/* Highest priority waiter */
+	if ((wait_queue->order == WAIT_PRIORITY) && (head->priority < tcb->priority))
+		wait_queue->head = tcb;
+} /* End of wait_queue_insert */
+
+/* 
+ * wait_queue_remove()
+ * Brief	: Removes a task from the wait queue it is in
+ * Param	: @tcb - TCB of a WAITING task
  * Retval	: None
- * Note		: N/A
+ * Note		: Must be called in a critical section.
  */
-void init_systick_timer(uint32_t tick_hz)
+void wait_queue_remove(TCB_t *tcb)
 {
-	uint32_t start_val = (SYSTICK_TIM_CLK / tick_hz) - 1;
+	wait_queue_t *wait_queue = tcb->wait_queue;
 
-	/* Clear the least significant 24 bits in the SYST_RVR */
-	SYST_RVR &= ~0x00FFFFFF;
+	if (tcb->next == tcb)
+	{
+		/* Last waiter */
+		wait_queue->head = NULL;
+	}
+	else
+	{
+		tcb->prev->next = tcb->next;
+		tcb->next->prev = tcb->prev;
 
-	/* Load the counter start value into SYST_RVR */
-	SYST_RVR |= start_val;
+		if (wait_queue->head == tcb)
+			wait_queue->head = tcb->next;
+	}
 
-	/* Configure SYST_CSR */
-	SYST_CSR |= (TICKINT | CLKSOURCE | ENABLE);
-		/* TICKINT	: Enable SysTick exception request */
-		/* CLKSOURCE: Specify clock source; processor clock source */
-		/* ENABLE	: Enable counter */
-} /* End of init_systick_timer */
+	tcb->next = NULL;
+	tcb->prev = NULL;
+	tcb->wait_queue = NULL;
+} /* End of wait_queue_remove */
 
 /* 
- * init_sched_stack()
- * Brief	: Initializes stack of scheduler
- * Param	: @sched_top_of_stack
- * Retval	: None
- * Note		: N/A
+ * select_next_task()
+ * Brief	: Selects the next task to run; the head of the highest priority
+ * 			  level that has a READY task
+ * Param	: None
+ * Retval	: TCB of the selected task
+ * Note		: Runs in constant time regardless of the number of tasks. The idle
+ * 			  task is always READY at IDLE_PRIORITY, so ready_bitmap is never 0.
+ * 			  Round-Robin among tasks of equal priority comes from rotating the
+ * 			  lists on every tick (See kernel_tick()); under SCHED_EDF, the head
+ * 			  is the task with the nearest deadline.
  */
-__attribute__((naked)) void init_sched_stack(uint32_t sched_top_of_stack)
+TCB_t *select_next_task(void)
 {
-	//__asm volatile("msr msp, r0");
-	__asm volatile("msr msp, %0": : "r" (sched_top_of_stack) : );
-	__asm volatile("bx lr");	/* Return to the caller */
-} /* End of init_sched_stack */
+	/* Highest set bit of the bitmap = highest priority with a READY task */
+	return ready_list[31U - __builtin_clz(ready_bitmap)];	/* Compiles to CLZ */
+} /* End of select_next_task */
 
+#if TICKLESS_IDLE
 /* 
- * get_psp()
- * Brief	: Retrieves the current task's psp value from its TCB
+ * ticks_to_next_wakeup()
+ * Brief	: Computes the number of ticks until the earliest BLOCKED task is
+ * 			  due to be unblocked
  * Param	: None
- * Retval	: None
- * Note		: N/A
+ * Retval	: Number of ticks (MAX_IDLE_TICKS if no task is BLOCKED)
+ * Note		: Must be called in a critical section.
  */
-uint32_t get_psp(void)
+uint32_t ticks_to_next_wakeup(void)
 {
-	return tcbs[curr_task].psp;
-} /* End of get_psp */
+	int32_t ticks;
+
+	if (sleep_queue == NULL)
+		return MAX_IDLE_TICKS;
+
+	/* Signed difference stays correct across global_tick_count wrap */
+	ticks = (int32_t)(sleep_queue->block_count - global_tick_count);
+
+	if (ticks <= 0)
+		return 0;
+
+	if ((uint32_t)ticks > MAX_IDLE_TICKS)
+		return MAX_IDLE_TICKS;
+
+	return (uint32_t)ticks;
+} /* End of ticks_to_next_wakeup */
+
+#endif /* TICKLESS_IDLE */
 
 /* 
- * save_psp()
- * Brief	: Saves the current task's psp value to its TCB
- * Param	: @curr_psp - current tasks's psp value
+ * Idle task handler()
+ * Brief	: Idle task handler
+ * Param	: @arg - Unused
  * Retval	: None
- * Note		: N/A
+ * Note		: Idle task will run only when all other user tasks are in BLOCKED
+ * 			  state. With TICKLESS_IDLE, it has the port suppress the periodic
+ * 			  tick and sleep until the next task is due.
  */
-void save_psp(uint32_t curr_psp)
+void idle_task_handler(void *arg)
 {
-	tcbs[curr_task].psp = curr_psp;
-} /* End of save_psp */
+	while (1)
+	{
+#if TICKLESS_IDLE
+		/* The port wakes up on a pending interrupt even while it is masked;
+		   the interrupt is then taken right after ENABLE_INTERRUPTS(). */
+		DISABLE_INTERRUPTS();
+
+		/* A user task may have been made READY after the idle task got the
+		   CPU. Otherwise, suppress the tick until the earliest wakeup and fix
+		   up the tick count with the number of ticks that were skipped. No
+		   deadline can have been skipped over since the port never sleeps
+		   past the one it is given. */
+		if (ready_bitmap == (1U << IDLE_PRIORITY))
+			global_tick_count += port_idle(ticks_to_next_wakeup());
+
+		ENABLE_INTERRUPTS();
+#endif
+	}
+} /* End of idle_task_handler */
 
 /* 
- * set_sp_to_psp()
- * Brief	: Sets the stack pointer to PSP
+ * schedule()
+ * Brief	: Selects the next task and triggers context switching by setting the
+ * 			  PendSV exception
  * Param	: None
  * Retval	: None
- * Note		: N/A
+ * Note		: Must be called in a critical section (or from an exception
+ * 			  handler).
  */
-__attribute__((naked)) void set_sp_to_psp(void)
+void schedule(void)
 {
-	/* 1. Initialize the PSP with Task1_STACK_START --------------------------*/
-	__asm volatile("push {lr}"); 	/* Secure LR before making a nested subroutine call */
-	__asm volatile("bl get_psp");	/* Get the PSP of the current task */
-	__asm volatile("msr psp, r0");	/* Initialize PSP; By AAPCS, r0 will contain Task1_STACK_START */
-	__asm volatile("pop {lr}"); 	/* Restore LR after returning from a nested subroutine */
-
-	/* 2. Make PSP the current stack pointer by setting bit[1](SPSEL) of CONTROL register */
-	__asm volatile("mov r0, #0x02");
-	__asm volatile("msr control, r0");
-	__asm volatile("bx lr");
-} /* End of set_sp_to_psp */
+	/* Make the scheduling decision here, so that PendSV_Handler() only has
+	   to switch to next_tcb */
+	next_tcb = select_next_task();
+
+	/* Pend the PendSV exception, unless the current task keeps the CPU. (If a
+	   switch is already pending, PendSV_Handler() takes the fast exit.) */
+	if (next_tcb != curr_tcb)
+		PEND_CONTEXT_SWITCH();
+} /* End of schedule */
 
 /* 
- * create_tasks()
- * Brief	: Create four tasks
- * Param	: @t1_handler - Pointer to task1 handler
- * 			: @t2_handler - Pointer to task2 handler
- * 			: @t3_handler - Pointer to task3 handler
- * 			: @t4_handler - Pointer to task4 handler
+ * sleep_until()
+ * Brief	: Blocks the current task until the given tick
+ * Param	: @wakeup_tick - Absolute tick count to unblock the task at
  * Retval	: None
- * Note		: N/A
+ * Note		: Must be called in a critical section. The switch happens once
+ * 			  the caller exits the critical section.
  */
-void create_tasks(void (*t1_handler)(void),
-				  void (*t2_handler)(void),
-				  void (*t3_handler)(void),
-				  void (*t4_handler)(void))
+void sleep_until(uint32_t wakeup_tick)
 {
-	/* Initialize Task Control Blocks (TCBs) */
-	tcbs[0].state = READY;	/* State of the idle task must always be READY */
-	tcbs[1].state = READY;
-	tcbs[2].state = READY;
-	tcbs[3].state = READY;
-	tcbs[4].state = READY;
-
-	tcbs[0].psp = IDLE_STACK_START;
-	tcbs[1].psp = T1_STACK_START;
-	tcbs[2].psp = T2_STACK_START;
-	tcbs[3].psp = T3_STACK_START;
-	tcbs[4].psp = T4_STACK_START;
-
-	tcbs[0].task_handler = idle_task_handler;
-	tcbs[1].task_handler = t1_handler;
-	tcbs[2].task_handler = t2_handler;
-	tcbs[3].task_handler = t3_handler;
-	tcbs[4].task_handler = t4_handler;
-
-	/* ARM Cortex-M4 processor stack model: Full-Descending */
-
-	uint32_t *p_psp;
-
-	/* Create initial dummy contexts */
-	for (int i = 0; i < NUM_TASKS; i++)
-	{
-		p_psp = (uint32_t *)tcbs[i].psp;
-
-		/* xPSR */
-		p_psp--;	/* To stay consistent with FD model: Decrement -> store */
-		*p_psp = DUMMY_XPSR;	/* 0x01000000; Set T-bit to specify Thumb ISA */
-
-		/* PC */
-		p_psp--;
-		*p_psp = (uint32_t)tcbs[i].task_handler;
-			/* Since ARM Cortex-M4 processor operates only in Thumb state, it's 
-			   also a good practice to check if the address of all task handlers
-			   is odd. */
-
-		/* LR */
-		p_psp--;
-		*p_psp = 0xFFFFFFFD;
-			/* EXC_RETURN[31:0] - Exception return behavior
-			   0xFFFFFFFD: Return to Thread mode, exception return uses 
-			   non-floating point state from the PSP and execution uses PSP 
-			   after return. -> Matches our environment! */
-
-		/* Set r0-r12 to 0 (optional) */
-		/*
-		for (int j = 0; j < 13; j++)
-		{
-			p_psp--;
-			// *p_psp = 0; // Don't know why this is setting p_psp to 0. 
-			// (Debug needed)
-		}
-		*/
-		p_psp -= 13;	/* space for r0-r12 */
+	/* Store in the block_count the timestamp to unblock the task */
+	curr_tcb->block_count = wakeup_tick;
+
+	/* Switch task state to BLOCKED and move it from the ready structure to
+	   the sleep queue */
+	curr_tcb->state = BLOCKED;
+	ready_list_remove(curr_tcb);
+	sleep_queue_insert(curr_tcb);
+
+	/* Allow other task to run */
+	schedule();
+} /* End of sleep_until */
 
-		/* Save the taks's PSP value for later use */
-		tcbs[i].psp = (uint32_t)p_psp;
+/* 
+ * block_task()
+ * Brief	: Blocks the task that calls this function for tick_count ticks 
+ * Param	: @tick_count - Number of ticks to block for, counted from now
+ * Retval	: None
+ * Note		: Time spent before the call adds up in a loop; periodic tasks
+ * 			  should use task_delay_until() instead.
+ */
+void block_task(uint32_t tick_count)
+{
+	if (!IS_PRIVILEGED())
+	{
+		(void)SYSCALL(SYS_BLOCK_TASK, tick_count, 0, 0, 0);
+		return;
 	}
-} /* End of create_tasks */
+
+	/* Do not allow changing the idle task state to BLOCKED. (Checked before
+	   entering the critical section, so as not to return from within it) */
+	if (curr_tcb == &tcbs[IDLE_TASK])
+		return;
+
+	/* To prevent race condition on global variables, mask the interrupts
+	   that may use the kernel */
+	ENTER_CRITICAL();
+
+	sleep_until(global_tick_count + tick_count);
+
+	EXIT_CRITICAL();
+} /* End of block_task */
 
 /* 
- * select_next_task()
- * Brief	: Selects the next available task based on the Round-Robin 
- * 			  scheduling policy 
- * Param	: None
+ * task_delay_until()
+ * Brief	: Blocks the calling task until period ticks after its previous
+ * 			  wakeup, for drift-free periodic execution
+ * Param	: @last_wake - Tick of the previous wakeup; initialize it with
+ * 						   get_tick_count() before the loop. Advanced by period
+ * 						   on every call.
+ * 			: @period - Period in ticks
  * Retval	: None
- * Note		: N/A
+ * Note		: Wakeups stay phase-locked to last_wake + n * period, however
+ * 			  long the task runs in between. If the next wakeup has already
+ * 			  passed (Overrun), it returns right away, and the following
+ * 			  periods catch up on the same phase.
  */
-void select_next_task()
+void task_delay_until(uint32_t *last_wake, uint32_t period)
 {
-	int state = BLOCKED;
+	uint32_t wakeup_tick;
 
-	/* Loop through the tasks for one cycle to search the schedulable user task */
-	for (int i = 0; i < NUM_TASKS; i++)
+	if (!IS_PRIVILEGED())
 	{
-		curr_task++;
-		curr_task %= NUM_TASKS;
-		state = tcbs[curr_task].state;
+		(void)SYSCALL(SYS_TASK_DELAY_UNTIL, last_wake, period, 0, 0);
+		return;
+	}
 
-		/* If the task is ready to be scheduled and is not the idle task */
-		if ((state == READY) && (curr_task != 0))
-		{
-			/* Stop searching and return. At this point curr_task contains
-			   the handle of the next task to be scheduled. */
-			return;
-		}
+	ENTER_CRITICAL();
+
+	wakeup_tick = *last_wake + period;
+	*last_wake = wakeup_tick;
+
+	/* Only block if the wakeup is still ahead (Wrap-safe). The idle task
+	   never blocks. */
+	if (((int32_t)(wakeup_tick - global_tick_count) > 0) &&
+		(curr_tcb != &tcbs[IDLE_TASK]))
+	{
+		sleep_until(wakeup_tick);
 	}
 
-	/* If there was no schedulable user task, select the idle task */
-	if (state != READY)
+	EXIT_CRITICAL();
+} /* End of task_delay_until */
+
+/* 
+ * kernel_wait()
+ * Brief	: Makes the current task wait on a kernel object
+ * Param	: @wait_queue - Wait queue of the object (NULL: Waiting for a
+ * 							direct notification; kernel_wake_task() only)
+ * 			: @timeout - Maximum number of ticks to wait (WAIT_FOREVER: No
+ * 						 limit). Must not be NO_WAIT.
+ * Retval	: None
+ * Note		: Must be called in a critical section, from a task other than
+ * 			  the idle task. The task is switched out once the caller exits
+ * 			  the critical section; when it runs again, curr_tcb->wait_result holds
+ * 			  E_OK if it was woken up by kernel_wake(), E_TIMEOUT otherwise.
+ */
+void kernel_wait(wait_queue_t *wait_queue, uint32_t timeout)
+{
+	curr_tcb->state = WAITING;
+	curr_tcb->wait_result = E_TIMEOUT;
+	ready_list_remove(curr_tcb);
+	if (wait_queue != NULL)
+		wait_queue_insert(wait_queue, curr_tcb);
+
+	/* The sleep queue takes care of the timeout */
+	if (timeout != WAIT_FOREVER)
 	{
-		curr_task = 0;
+		curr_tcb->block_count = global_tick_count + timeout;
+		sleep_queue_insert(curr_tcb);
 	}
-} /* End of select_next_task */
+
+	schedule();
+} /* End of kernel_wait */
 
 /* 
- * PendSV_Handler()
- * Brief	: Performs context switching
- * Param	: None
+ * kernel_wake_task()
+ * Brief	: Wakes up a given task waiting on a kernel object
+ * Param	: @tcb - TCB of a WAITING task
+ * 			: @result - Result handed to the woken task (wait_result)
  * Retval	: None
- * Note		: N/A
+ * Note		: Must be called in a critical section (or from an exception
+ * 			  handler). The caller calls schedule() afterwards, so that waking
+ * 			  a higher priority task preempts right away through PendSV.
  */
-__attribute__((naked)) void PendSV_Handler(void)
+void kernel_wake_task(TCB_t *tcb, int32_t result)
 {
-	/* SF1(r0-r3, r12, lr, pc, xpsr) of the current task are automatically 
-	   pushed onto its stack by the processor as exception ENTRY sequence. 
-	   (i.e., Stacking) */
+	if (tcb->wait_queue != NULL)
+		wait_queue_remove(tcb);
+
+	/* Cancel the timeout */
+	if ((tcb->sleep_prev != NULL) || (sleep_queue == tcb))
+		sleep_queue_remove(tcb);
+
+	tcb->wait_result = result;
+	tcb->state = READY;
+#if SCHED_EDF
+	/* New release */
+	tcb->abs_deadline = global_tick_count + tcb->deadline;
+#endif
+	ready_list_insert(tcb);
+} /* End of kernel_wake_task */
 
-	/* CAUTION!
-	   You are in an EXCEPTION HANDLER, which uses MSP. When you use push/pop 
-	   operation in this handler, MSP will be affected! */
+/* 
+ * kernel_wake()
+ * Brief	: Wakes up the first task waiting on a kernel object
+ * Param	: @wait_queue - Wait queue of the object
+ * 			: @result - Result handed to the woken task (wait_result)
+ * Retval	: TCB of the woken task, NULL if there was no waiter
+ * Note		: Must be called in a critical section (or from an exception
+ * 			  handler). The caller calls schedule() afterwards.
+ */
+TCB_t *kernel_wake(wait_queue_t *wait_queue, int32_t result)
+{
+	TCB_t *tcb = wait_queue->head;
 
-	/***************************************************************************
-	 * PART1: Task switching out (Save the context of the current task)
-	 **************************************************************************/
+	if (tcb != NULL)
+		kernel_wake_task(tcb, result);
 
-	/* 1. Get the current task's PSP */
-	__asm volatile("mrs r0, psp");
+	return tcb;
+} /* End of kernel_wake */
 
-	/* 2. Save SF2(r4-r11) of the current task by using its PSP */
-	__asm volatile("stmdb r0!, {r4-r11}"); 	/* Register to memory */
-		/* STMDB: STore Multiple registers. Decrement address Before each access.
-		   !	: An optional writeback suffix. If ! is present the final address,
-				  that is loaded from or stored to, is written back into the base
-				  register. In this case, r0. */
+/* 
+ * kernel_set_priority()
+ * Brief	: Changes the effective priority of a task
+ * Param	: @tcb - TCB of the task
+ * 			: @priority - New priority (base_priority is left unchanged)
+ * Retval	: None
+ * Note		: Must be called in a critical section. A READY task moves to the
+ * 			  tail of its new level, and a task WAITING in a WAIT_PRIORITY
+ * 			  queue is re-queued so that the queue stays ordered. The caller calls schedule()
+ * 			  afterwards. Used by priority inheritance (mutex.c).
+ */
+void kernel_set_priority(TCB_t *tcb, uint8_t priority)
+{
+	wait_queue_t *wait_queue;
 
-	/* 3. Save the updated PSP of the current task */
-	__asm volatile("push {lr}");
-		/* Secure LR before making a nested subroutine call. Here LR contains
-		   (EXC_RETURN[31:0] - 0xFFFFFFFD) that is updated at the exception 
-		   entry sequence. */
-	__asm volatile("bl save_psp");
+	if (tcb->priority == priority)
+		return;
 
-	/***************************************************************************
-	 * PART2: Task switching in (Restore the context of the next task)
-	 **************************************************************************/
+	if (tcb->state == READY)
+	{
+		ready_list_remove(tcb);
+		tcb->priority = priority;
+		ready_list_insert(tcb);
+	}
+	else if ((tcb->state == WAITING) && (tcb->wait_queue != NULL) &&
+			 (tcb->wait_queue->order == WAIT_PRIORITY))
+	{
+		wait_queue = tcb->wait_queue;
+		wait_queue_remove(tcb);
+		tcb->priority = priority;
+		wait_queue_insert(wait_queue, tcb);
+	}
+	else
+	{
+		tcb->priority = priority;
+	}
+} /* End of kernel_set_priority */
 
-	/* 1. Choose the next task to run */
-	__asm volatile("bl select_next_task");
+/* 
+ * task_notify()
+ * Brief	: Sends a direct notification to a task, updating its notification
+ * 			  word
+ * Param	: @task - Handle of the task to notify
+ * 			: @value - Value used by the action (Unused for NOTIFY_GIVE)
+ * 			: @action - NOTIFY_GIVE, NOTIFY_SET_BITS or NOTIFY_OVERWRITE
+ * Retval	: E_OK on success, E_INVALID on invalid arguments
+ * Note		: Can be called from an ISR. A lighter alternative to a semaphore
+ * 			  or an event group when there is exactly one task to wake up: No
+ * 			  object and no wait queue, just the TCB.
+ */
+int task_notify(TCB_t *task, uint32_t value, uint8_t action)
+{
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_TASK_NOTIFY, task, value, action, 0);
 
-	/* 2. Get the next task's PSP */
-	__asm volatile("bl get_psp");	/* Get the PSP of the current task */
+	if (task == NULL)
+		return E_INVALID;
 
-	/* 3. Restore SF2(r4-r11) of the next task by using its PSP */
-	__asm volatile("ldmia r0!, {r4-r11}");	/* Memory to register */
-		/* LDMIA: LoaD Multiple registers. Increment address After each access.
-		   !	: An optional writeback suffix. If ! is present the final 
-		   		  address, that is loaded from or stored to, is written back 
-				  into the base register. In this case, r0. */
+	ENTER_CRITICAL();
 
-	/* 4. Update PSP */
-	__asm volatile("msr psp, r0");	/* Now PSP points to the stack of the task switched in */
+	switch (action)
+	{
+	case NOTIFY_GIVE:
+		task->notify_value++;
+		break;
+	case NOTIFY_SET_BITS:
+		task->notify_value |= value;
+		break;
+	case NOTIFY_OVERWRITE:
+		task->notify_value = value;
+		break;
+	default:
+		EXIT_CRITICAL();
+		return E_INVALID;
+	}
 
-	__asm volatile("pop {lr}");		/* Restore LR (EXC_RETURN[31:0] - 0xFFFFFFFD) */
+	/* A task that timed out is READY until it runs again, and then finds
+	   the notification pending */
+	if ((task->notify_state == NOTIFY_WAITING) && (task->state == WAITING))
+	{
+		task->notify_state = NOTIFY_PENDING;
+		kernel_wake_task(task, E_OK);
+		schedule();
+	}
+	else
+	{
+		task->notify_state = NOTIFY_PENDING;
+	}
 
-	__asm volatile("bx lr");
+	EXIT_CRITICAL();
 
-	/* SF1(r0-r3, r12, lr, pc, xpsr) of the current task are automatically 
-	   popped out of its stack and restored by the processor as exception EXIT 
-	   sequence. (i.e., UnstackingG) */
-} /* End of PendSV_Handler */
+	return E_OK;
+} /* End of task_notify */
 
 /* 
- * unblock_tasks()
- * Brief	: Checks all the tasks' states and unblock all the tasks that are 
- * 			  qualified 
- * Param	: None
- * Retval	: None
- * Note		: N/A
+ * task_notify_from_isr()
+ * Brief	: Sends a direct notification to a task from an ISR
+ * Param	: @task - Handle of the task to notify
+ * 			: @value - Value used by the action (Unused for NOTIFY_GIVE)
+ * 			: @action - NOTIFY_GIVE, NOTIFY_SET_BITS or NOTIFY_OVERWRITE
+ * Retval	: E_OK on success, E_INVALID on invalid arguments
+ * Note		: The woken task runs as soon as the ISR returns, through PendSV.
  */
-void unblock_tasks(void)
+int task_notify_from_isr(TCB_t *task, uint32_t value, uint8_t action)
+{
+	return task_notify(task, value, action);
+} /* End of task_notify_from_isr */
+
+/* 
+ * task_notify_wait()
+ * Brief	: Waits for a direct notification to the calling task
+ * Param	: @clear_bits - Bits of the notification word to clear on exit
+ * 						   (0xFFFFFFFF: Reset it, e.g., to consume a count)
+ * 			: @value - Where to store the notification word as it was before
+ * 					   clearing; may be NULL
+ * 			: @timeout - Maximum number of ticks to wait (NO_WAIT: Do not wait,
+ * 						 WAIT_FOREVER: No limit)
+ * Retval	: E_OK if notified, E_TIMEOUT if not notified in time
+ * Note		: Returns right away if notified since the last call. Tasks only,
+ * 			  except the idle task.
+ */
+int task_notify_wait(uint32_t clear_bits, uint32_t *value, uint32_t timeout)
 {
-	for (int i = 1; i < NUM_TASKS; i++)
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_TASK_NOTIFY_WAIT, clear_bits, value, timeout, 0);
+
+	ENTER_CRITICAL();
+
+	if (curr_tcb->notify_state != NOTIFY_PENDING)
 	{
-		if (tcbs[i].state != READY)
+		if (timeout == NO_WAIT)
+		{
+			EXIT_CRITICAL();
+			return E_TIMEOUT;
+		}
+
+		curr_tcb->notify_state = NOTIFY_WAITING;
+		kernel_wait(NULL, timeout);
+
+		/* Switched out here, until notified or timed out */
+		EXIT_CRITICAL();
+		ENTER_CRITICAL();
+
+		if (curr_tcb->notify_state != NOTIFY_PENDING)
 		{
-			/* If the blocking time has elapsed */
-			if (tcbs[i].block_count == global_tick_count)
-			{
-				tcbs[i].state = READY;
-			}
+			curr_tcb->notify_state = NOTIFY_IDLE;
+			EXIT_CRITICAL();
+			return E_TIMEOUT;
 		}
 	}
-} /* End of unblock_tasks */
+
+	if (value != NULL)
+		*value = curr_tcb->notify_value;
+
+	curr_tcb->notify_value &= ~clear_bits;
+	curr_tcb->notify_state = NOTIFY_IDLE;
+
+	EXIT_CRITICAL();
+
+	return E_OK;
+} /* End of task_notify_wait */
 
 /* 
- * SysTick_Handler()
- * Brief	: Increments the global tick count, unblocks qualified tasks, and 
- * 			  pends the PendSV exception to trigger context switching 
+ * get_tick_count()
+ * Brief	: Returns the number of ticks since the kernel was started
  * Param	: None
- * Retval	: None
- * Note		: N/A
+ * Retval	: Global tick count
+ * Note		: A system call for unprivileged tasks, which can't read the
+ * 			  kernel data.
  */
-void SysTick_Handler(void)
+uint32_t get_tick_count(void)
 {
-	/* Increment the global tick count */
-	global_tick_count++;
+	if (!IS_PRIVILEGED())
+		return SYSCALL(SYS_GET_TICK_COUNT, 0, 0, 0, 0);
 
-	/* Checks all the tasks' states and unblock all the tasks that are qualified */
-	unblock_tasks();
+	return global_tick_count;
+} /* End of get_tick_count */
+
+/*
+ * task_is_valid()
+ * Brief	: Tells whether a pointer is the handle of an existing task
+ * Param	: @task - Pointer to check
+ * Retval	: 1 if task is one of the TCBs in use, 0 otherwise
+ * Note		: Used to check the task handles unprivileged tasks pass to
+ * 			  system calls (svc.c).
+ */
+int task_is_valid(TCB_t *task)
+{
+	uintptr_t offset = (uintptr_t)task - (uintptr_t)tcbs;
 
-	/* Pend the PendSV exception */
-	ICSR |= PENDSVSET;
-} /* End of SysTick_Handler */
+	return ((offset < ((IDLE_TASK + 1U + num_tasks) * sizeof(TCB_t))) &&
+			((offset % sizeof(TCB_t)) == 0));
+} /* End of task_is_valid */
 
 /* 
- * enable_processor_faults()
- * Brief	: Enable all configurable exceptions (i.e., UsageFault, MemManage, 
- * 			  BusFault) 
- * Param	: None
- * Retval	: None
- * Note		: N/A
+ * init_task()
+ * Brief	: Initializes a TCB, carves its stack from the stack pool, builds the
+ * 			  initial dummy context and makes the task READY
+ * Param	: @tcb - TCB to initialize
+ * 			: @task_handler - Pointer to task handler
+ * 			: @arg - Argument passed to the task handler
+ * 			: @stack_size - Stack size in bytes
+ * 			: @priority - Scheduling priority
+ * Retval	: 0 on success, -1 if the stack pool is exhausted
+ * Note		: Must be called in a critical section.
  */
-void enable_processor_faults(void)
+int init_task(TCB_t *tcb, void (*task_handler)(void *), void *arg,
+			  uint32_t stack_size, uint8_t priority)
 {
-	SHCSR |= USGFAULTENA;	/* Enable UsageFault */
-	SHCSR |= BUSFAULTENA;	/* Enable BusFault */
-	SHCSR |= MEMFAULTENA;	/* Enable MemManage */
+	uintptr_t stack_base;
+
+	/* Round the stack to what the port can protect (At least a multiple of 8
+	   bytes, so that all stacks stay 8-byte aligned), and align it */
+	stack_size = STACK_SIZE_ROUND(stack_size);
+	stack_base = ((uintptr_t)stack_pool + stack_pool_used + (STACK_ALIGN(stack_size) - 1U)) &
+				 ~(uintptr_t)(STACK_ALIGN(stack_size) - 1U);
+
+	if ((stack_base + stack_size) > ((uintptr_t)stack_pool + SIZE_STACK_POOL))
+		return -1;
+
+	tcb->stack_base = stack_base;
+	tcb->stack_size = stack_size;
+	stack_pool_used = (uint32_t)(stack_base + stack_size - (uintptr_t)stack_pool);
+#if MPU_ENABLED
+	port_mpu_stack_regions(stack_base, stack_size, tcb->mpu_regions);
+#endif
+
+	tcb->control = TASK_CONTROL;
+	tcb->svc_return = 0;
+	tcb->state = READY;
+	tcb->priority = priority;
+	tcb->base_priority = priority;
+	tcb->notify_value = 0;
+	tcb->notify_state = NOTIFY_IDLE;
+#if SCHED_EDF
+	tcb->deadline = NO_DEADLINE;
+	tcb->abs_deadline = 0;
+#endif
+	tcb->task_handler = task_handler;
+	tcb->arg = arg;
+
+#if STACK_CHECK
+	/* Paint the whole stack; the initial context is built over it */
+	for (uint32_t *p = (uint32_t *)tcb->stack_base; p < (uint32_t *)(tcb->stack_base + stack_size); p++)
+		*p = STACK_PAINT;
+#endif
+
+	/* Build the initial context the port will switch to */
+	tcb->psp = port_init_stack(tcb->stack_base, tcb->stack_size, task_handler, arg);
+
+	ready_list_insert(tcb);
+
+	return 0;
+} /* End of init_task */
 
-	/* Since the kernel performs various memory access enabling these faults will help us
-	 * track down the issues.
-	 */
-} /* End of enable_processor_faults *.
+/* 
+ * task_create()
+ * Brief	: Creates a task with its own stack size and priority
+ * Param	: @task_handler - Pointer to task handler
+ * 			: @arg - Argument passed to the task handler
+ * 			: @stack_size - Stack size in bytes (At least MIN_STACK_SIZE)
+ * 			: @priority - Scheduling priority (IDLE_PRIORITY < priority <
+ * 						  NUM_PRIORITIES)
+ * Retval	: Handle (TCB) of the created task, NULL on failure
+ * Note		: TCBs and stacks come from statically sized pools (MAX_TASKS,
+ * 			  SIZE_STACK_POOL). Tasks can be created before or after
+ * 			  start_kernel(); they are never deleted. A task created at a
+ * 			  higher priority than the caller runs before task_create()
+ * 			  returns.
+ */
+TCB_t *task_create(void (*task_handler)(void *), void *arg,
+				   uint32_t stack_size, uint8_t priority)
+{
+	TCB_t *tcb = NULL;
+
+	if (!IS_PRIVILEGED())
+		return (TCB_t *)SYSCALL(SYS_TASK_CREATE, task_handler, arg, stack_size, priority);
+
+	if ((task_handler == NULL) || (stack_size < MIN_STACK_SIZE) || (stack_size > SIZE_STACK_POOL) ||
+		(priority <= IDLE_PRIORITY) || (priority >= NUM_PRIORITIES))
+	{
+		return NULL;
+	}
+
+	ENTER_CRITICAL();
+
+	if (num_tasks < (MAX_TASKS - 1U))
+	{
+		tcb = &tcbs[IDLE_TASK + 1U + num_tasks];
+
+		if (init_task(tcb, task_handler, arg, stack_size, priority) == 0)
+		{
+			num_tasks++;
+
+			/* Once the kernel is running, a task of a higher priority than
+			   the creator preempts it right away (Not at the next tick) */
+			if ((curr_tcb != NULL) && (priority > curr_tcb->priority))
+				schedule();
+		}
+		else
+		{
+			tcb = NULL;
+		}
+	}
+
+	EXIT_CRITICAL();
 
+	return tcb;
+} /* End of task_create */
+
+#if SCHED_EDF
 /* 
- * HardFault_Handler()
- * Brief	: HardFault handler 
- * Param	: None
- * Retval	: None
- * Note		: N/A
+ * task_set_deadline()
+ * Brief	: Declares the relative deadline of a task (SCHED_EDF)
+ * Param	: @task - Handle of the task (Returned by task_create())
+ * 			: @deadline - Relative deadline in ticks, counted from each release
+ * 						  of the task (NO_DEADLINE: Run after the tasks that
+ * 						  have one)
+ * Retval	: 0 on success, -1 if task is NULL or the idle task
+ * Note		: A READY task is released right away (Its absolute deadline counts
+ * 			  from now); a BLOCKED one on its next wakeup.
+ */
+int task_set_deadline(TCB_t *task, uint32_t deadline)
+{
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_TASK_SET_DEADLINE, task, deadline, 0, 0);
+
+	if ((task == NULL) || (task == &tcbs[IDLE_TASK]))
+		return -1;
+
+	ENTER_CRITICAL();
+
+	task->deadline = deadline;
+
+	if (task->state == READY)
+	{
+		/* Re-insert at its new place in the deadline order */
+		ready_list_remove(task);
+		task->abs_deadline = global_tick_count + deadline;
+		ready_list_insert(task);
+
+		/* May preempt the caller once the kernel is running */
+		if (curr_tcb != NULL)
+			schedule();
+	}
+
+	EXIT_CRITICAL();
+
+	return 0;
+} /* End of task_set_deadline */
+
+#endif /* SCHED_EDF */
+
+#if STACK_CHECK
+/*
+ * task_stack_high_water()
+ * Brief	: Measures the most stack a task has ever used
+ * Param	: @task - Handle of the task (NULL: The calling task)
+ * Retval	: Peak stack usage in bytes (Out of the stack size given to
+ * 			  task_create(), rounded up by STACK_SIZE_ROUND(), less
+ * 			  STACK_GUARD_SIZE)
+ * Note		: Counts the words still holding STACK_PAINT from the lowest
+ * 			  address up, so it takes longer the less of the stack has been
+ * 			  used. Meant for sizing the stacks from a long run: A stack whose
+ * 			  high-water mark stays well below its size can be made smaller.
  */
-void HardFault_Handler(void)
+uint32_t task_stack_high_water(TCB_t *task)
 {
-	printf("Exception: HardFault\n");
-	while (1);
-} /* End of HardFault_Handler() */
+	uint32_t *p;
+	uint32_t *top;
+
+	if (!IS_PRIVILEGED())
+		return SYSCALL(SYS_TASK_STACK_HIGH_WATER, task, 0, 0, 0);
+
+	if (task == NULL)
+		task = curr_tcb;
+
+	p = (uint32_t *)(task->stack_base + STACK_GUARD_SIZE);	/* The guard can't be read */
+	top = (uint32_t *)(task->stack_base + task->stack_size);
+
+	while ((p < top) && (*p == STACK_PAINT))
+		p++;
+
+	return (uint32_t)((uintptr_t)top - (uintptr_t)p);
+} /* End of task_stack_high_water */
+#endif /* STACK_CHECK */
 
 /* 
- * MemManage_Handler()
- * Brief	: MemManage handler 
+ * unblock_tasks()
+ * Brief	: Unblocks all the tasks whose blocking time has elapsed, including
+ * 			  the ones whose wait on a kernel object timed out
  * Param	: None
  * Retval	: None
- * Note		: N/A
+ * Note		: Only the expired head entries of the sleep queue are visited, so
+ * 			  the cost is proportional to the number of tasks woken up, not to
+ * 			  the number of tasks. The deadline test is a signed difference, so
+ * 			  it is wrap-safe and a wakeup is not missed when ticks were skipped
+ * 			  (e.g., by the tickless idle mode).
  */
-void MemManage_Handler(void)
+void unblock_tasks(void)
 {
-	printf("Exception: HardFault\n");
-	while (1);
-} /* End of MemManage_Handler() */
+	TCB_t *tcb;
+
+	while ((sleep_queue != NULL) &&
+		   ((int32_t)(global_tick_count - sleep_queue->block_count) >= 0))
+	{
+		tcb = sleep_queue;
+		sleep_queue_remove(tcb);
+
+		/* Timed out waiting on a kernel object (Or for a notification) */
+		if (tcb->state == WAITING)
+		{
+			if (tcb->wait_queue != NULL)
+				wait_queue_remove(tcb);
+			tcb->wait_result = E_TIMEOUT;
+		}
+
+		tcb->state = READY;
+#if SCHED_EDF
+		/* New release: Its deadline counts from the tick it was due to wake
+		   up at, so that periodic tasks keep a fixed phase */
+		tcb->abs_deadline = tcb->block_count + tcb->deadline;
+#endif
+		ready_list_insert(tcb);
+	}
+} /* End of unblock_tasks */
 
 /* 
- * BusFault_Handler()
- * Brief	: BusFault handler 
+ * kernel_tick()
+ * Brief	: Increments the global tick count, rotates the current priority
+ * 			  level, unblocks qualified tasks, and requests a context switch if
+ * 			  the next task changed
  * Param	: None
  * Retval	: None
- * Note		: N/A
+ * Note		: Called by the port's tick interrupt (SysTick_Handler() on the
+ * 			  target).
  */
-void BusFault_Handler(void)
+void kernel_tick(void)
 {
+#if KERNEL_STATS
+	uint32_t start = CYCLE_COUNT();
+#endif
+
+	/* Kernel aware ISRs of a higher priority may preempt the tick */
+	ENTER_CRITICAL();
+
+	/* Increment the global tick count */
+	global_tick_count++;
+
+	/* Round-Robin: The current task's time slice is over. If it is at the
+	   head of its level, rotate the circular list so that the next task of
+	   the same priority gets the CPU (O(1), just a head update). */
+	if ((curr_tcb->state == READY) && (ready_list[curr_tcb->priority] == curr_tcb))
+	{
+#if SCHED_EDF
+		/* Tasks with a deadline keep the CPU until they block or a nearer
+		   deadline is released; only the ones without rotate. (With no
+		   deadline at the head, the whole level has none.) */
+		if (curr_tcb->deadline == NO_DEADLINE)
+#endif
+		ready_list[curr_tcb->priority] = curr_tcb->next;
+	}
+
+	/* Unblock all the tasks whose blocking time has elapsed */
+	unblock_tasks();
+
+	/* Select the next task and pend the context switch if it changed */
+	schedule();
+
+	EXIT_CRITICAL();
 
-	printf("Exception: BusFault\n");
-	while (1);
-} /* End of BusFault_Handler() */
+#if KERNEL_STATS
+	kernel_stats.tick_isr_cycles = CYCLE_COUNT() - start;
+	if (kernel_stats.tick_isr_cycles > kernel_stats.tick_isr_cycles_max)
+		kernel_stats.tick_isr_cycles_max = kernel_stats.tick_isr_cycles;
+#endif
+} /* End of kernel_tick */
 
 /* 
  * start_kernel()
@@ -457,14 +1043,21 @@ void BusFault_Handler(void)
  */
 void start_kernel(void)
 {
-	enable_processor_faults();
+	/* Architecture specific setup (Fault handlers, FPU, exception priorities) */
+	port_init();
 
-	init_sched_stack(SCHED_STACK_START);
+	/* Create the idle task; it stays READY at IDLE_PRIORITY forever */
+	init_task(&tcbs[IDLE_TASK], idle_task_handler, NULL, SIZE_IDLE_STACK,
+			  IDLE_PRIORITY);
 
-	init_systick_timer(TICK_HZ);
+	/* The idle task stays privileged: It masks interrupts and reprograms the
+	   tick source (port_idle()) */
+	tcbs[IDLE_TASK].control = 0U;
 
-	set_sp_to_psp();
+	/* The first task to run is the head of the highest ready priority */
+	curr_tcb = select_next_task();
+	next_tcb = curr_tcb;
 
-	/* Invoke task1_handler */
-	(tcbs[1].task_handler)();
+	/* Start the tick and run the first task; does not return */
+	port_start_first_task();
 } /* End of start_kernel */
@@ -8,87 +8,187 @@
 #ifndef KERNEL_H
 #define KERNEL_H
 
+#include <stdint.h>
+#include "port.h"
+
 /* Stack memory information */
-#define SIZE_TASK_STACK		1024U
-#define SIZE_SCHED_STACK	1024U
-#define SRAM_START			0x20000000U
-#define SIZE_SRAM			((128) * (1024))
-#define SRAM_END			((SRAM_START) + (SIZE_SRAM))
-
-#define IDLE_STACK_START	SRAM_END
-#define T1_STACK_START		((SRAM_END) - (1 * (SIZE_TASK_STACK)))
-#define T2_STACK_START		((SRAM_END) - (2 * (SIZE_TASK_STACK)))
-#define T3_STACK_START		((SRAM_END) - (3 * (SIZE_TASK_STACK)))
-#define T4_STACK_START		((SRAM_END) - (4 * (SIZE_TASK_STACK)))
-#define SCHED_STACK_START	((SRAM_END) - (5 * (SIZE_TASK_STACK)))
-
-/* System timer registers */
-/* SysTick Reload Value Register (Stores 24-bit down counter START value) */
-#define SYST_RVR			(*(uint32_t volatile *)0xE000E014)
-/* SysTick Control and Status Register */
-#define SYST_CSR			(*(uint32_t volatile *)0xE000E010)
-#define ENABLE				(1 << 0U) /* Counter enabled */
-#define TICKINT				(1 << 1U) /* Counting down to zero asserts the SysTick exception request */
-#define CLKSOURCE			(1 << 2U) /* Processor clock */
-
-/* PendSV */
-/* Interrupt Control and State Register (ICSR) */
-#define ICSR				(*(uint32_t volatile *)0xE000ED04)
-#define PENDSVSET			(1 << 28U)	/* Change PendSV exception state to pending */
-
-/* Disable interrupts */
-#define DISABLE_INTERRUPTS()	do { __asm volatile ("CPSID i"); } while (0)
-	/* To disable interrupts for ARM Cortex-M4 processor, you can use the 
-	   "CPSID i" assembly instruction. This instruction sets the "PRIMASK" 
-	   register to disable all interrupts, including the non-maskable 
-	   interrupt (NMI). */
-	/* The do-while loop construct ensures that the macro expands to a single 
-	   statement, even if it is used in a context where multiple statements are 
-	   expected (e.g., as the body of an if statement). The while (0) part of 
-	   the loop is there to ensure that the macro can be used safely in compound
-	   statements without generating syntax errors. */
-	/* Another way of writing DISABLE_INTERRUPTS() is as follows:
-	   do { __asm volatile ("mov r0, #0x1"); asm volatile ("mrs primask, r0"); } while (0)
-	   In this case, using do-while statement helps ensuring that the compound 
-	   statements in the body expand to a single statement, as we put parens 
-	   around every single macro variables. */
-
-/* Enable interrupts */
-#define ENABLE_INTERRUPTS() 	do { __asm volatile ("CPSIE i"); } while (0)
-	/* Another way of writing DISABLE_INTERRUPTS() is as follows:
-	   do { __asm volatile ("mov r0, #0x0"); asm volatile ("mrs primask, r0"); } while (0)  */
-
-/* Clock */
-#define HSI_CLK				16000000U
-#define SYSTICK_TIM_CLK		HSI_CLK		/* By default */
+#define SIZE_TASK_STACK		1024U	/* Default task stack size */
+#ifndef SIZE_IDLE_STACK
+#define SIZE_IDLE_STACK		256U
+#endif
+
+/* Task stacks are carved from a statically allocated pool (KERNEL_DATA: CCM RAM
+   on the target, .bss on the host) */
+#ifndef SIZE_STACK_POOL
+#define SIZE_STACK_POOL		((16) * (1024))
+#endif
+
+/* Stack checking: Every task stack is painted with STACK_PAINT when the task
+   is created. The untouched part tells how much of it the task ever used
+   (task_stack_high_water()), and the port checks the stack of every task it
+   switches out: Its saved context must lie within the stack, and the lowest
+   word must still hold the paint (Unless the port guards the stacks with an
+   MPU, MPU_ENABLED, which traps the overflow itself). Build with
+   -DSTACK_CHECK=0 to skip both. */
+#ifndef STACK_CHECK
+#define STACK_CHECK			1U
+#endif
+#define STACK_PAINT			0xA5A5A5A5U
 
 /* SysTick Timer */
 #define TICK_HZ				1000U	/* Desired tick frequency */
 
-#define NUM_TASKS			5U
-#define DUMMY_XPSR			0x01000000U	/* Guarantee T-bit is set */
+/* Tickless idle: While only the idle task is runnable, the tick source is
+   reprogrammed to fire at the earliest wakeup instead of every tick. Build with
+   -DTICKLESS_IDLE=0 to keep the periodic tick. */
+#ifndef TICKLESS_IDLE
+#define TICKLESS_IDLE		1U
+#endif
+#define TICKLESS_MIN_IDLE_TICKS	2U	/* Shorter idle periods just wait for the next tick */
+
+#ifndef MAX_TASKS
+#define MAX_TASKS			16U		/* Size of the TCB pool (Idle task included) */
+#endif
+#define IDLE_TASK			0U		/* tcbs[] index of the idle task */
+
+/* Scheduler */
+#define NUM_PRIORITIES		32U		/* One bit per level in the 32-bit ready bitmap */
+#define IDLE_PRIORITY		0U		/* Lowest priority; reserved for the idle task */
+#define DEFAULT_PRIORITY	1U		/* Priority given to user tasks */
 
-/* System Handler Control and State Register (SHCRS); one of the System Control Block registers */
-#define	SHCSR				(*(uint32_t volatile *)0xE000ED24)
-#define USGFAULTENA			(1 << 18U)
-#define BUSFAULTENA			(1 << 17U)
-#define MEMFAULTENA			(1 << 16U)
-/* UsageFault Status Register (UFSR) - 16-bit register */
-#define UFSR				(*(uint32_t volatile *)0xE000ED2A)
-/* Configuration and Control Register */
-#define CCR					(*(uint32_t volatile *)0xE000ED14)
-#define DIV_0_TRP			(1 << 4U)
+/* Earliest-Deadline-First: Build with -DSCHED_EDF=1 to order the READY tasks of
+   each priority level by absolute deadline instead of Round-Robin. A task that
+   declared a relative deadline (task_set_deadline()) gets an absolute deadline
+   each time it is released (created or woken up); the nearest one runs first.
+   Tasks without a deadline run after them, Round-Robin. */
+#ifndef SCHED_EDF
+#define SCHED_EDF			0U
+#endif
+#define NO_DEADLINE			0U		/* Relative deadline of tasks that declared none */
+
+/* Kernel statistics: Build with -DKERNEL_STATS=1 to time the kernel paths with
+   the port's cycle counter (DWT on the target). */
+#ifndef KERNEL_STATS
+#define KERNEL_STATS		0U
+#endif
+
+#if KERNEL_STATS
+typedef struct
+{
+	uint32_t tick_isr_cycles;		/* Duration of the last tick processing */
+	uint32_t tick_isr_cycles_max;	/* Longest tick processing so far */
+} kernel_stats_t;
+
+extern kernel_stats_t kernel_stats;
+#endif
 
 /* Task States */
 #define READY				0x00U
-#define BLOCKED				0xFFU
+#define WAITING				0x01U	/* Waiting on a kernel object (Maybe with a timeout) */
+#define BLOCKED				0xFFU	/* Sleeping for a number of ticks */
+
+/* Timeouts of the blocking calls (In ticks) */
+#define NO_WAIT				0U			/* Fail right away instead of blocking */
+#define WAIT_FOREVER		0xFFFFFFFFU	/* Block until the object is available */
+
+/* Return codes of the blocking calls */
+#define E_OK				0		/* Success */
+#define E_TIMEOUT			(-1)	/* Timed out (Or would have blocked with NO_WAIT) */
+#define E_INVALID			(-2)	/* Invalid argument or operation */
+#define E_FULL				(-3)	/* No room left (Non-blocking producers) */
+
+/* Direct-to-task notification actions (task_notify()) */
+#define NOTIFY_GIVE			0U		/* Increment the notification word (Counting) */
+#define NOTIFY_SET_BITS		1U		/* OR the value into the notification word */
+#define NOTIFY_OVERWRITE	2U		/* Replace the notification word with the value */
+
+/* Notification states */
+#define NOTIFY_IDLE			0U
+#define NOTIFY_PENDING		1U		/* Notified since the last task_notify_wait() */
+#define NOTIFY_WAITING		2U		/* WAITING in task_notify_wait() */
+
+/* Wait queue orders */
+#define WAIT_FIFO			0U		/* Waiters are served in arrival order */
+#define WAIT_PRIORITY		1U		/* Highest priority waiter first (FIFO among equals) */
+
+/* Queue of the tasks waiting on a kernel object (e.g., a semaphore); a
+   circular doubly-linked list through the TCBs' next/prev links, which a
+   WAITING task does not use for the ready list */
+typedef struct wait_queue
+{
+	struct TCB *head;				/* Next task to be woken up (NULL: No waiter) */
+	uint8_t order;					/* WAIT_FIFO or WAIT_PRIORITY */
+} wait_queue_t;
+
+struct mutex;
+
+/* Structure for Task Control Blocks (TCBs) */
+typedef struct TCB
+{
+	uintptr_t psp;					/* Task stack pointer (Must stay first; PendSV_Handler uses offset 0) */
+	uint32_t control;				/* CONTROL.nPRIV of the task (Must stay second; PendSV_Handler uses offset 4) */
+	uintptr_t stack_base;			/* Lowest address of the task stack (Must stay third; PendSV_Handler
+									   uses offset 8) */
+#if MPU_ENABLED
+	uint32_t mpu_regions[4];		/* MPU RBAR/RASR pairs of its stack and stack guard (Must stay
+									   fourth; PendSV_Handler uses offset 12) */
+#endif
+	uint32_t svc_return;			/* Where the current system call returns to */
+	uint32_t block_count;			/* How long it should block */
+	uint8_t state;					/* Task state */
+	uint8_t priority;				/* Scheduling priority (Higher value runs first) */
+	uint8_t base_priority;			/* Priority assigned at creation (Without inheritance) */
+	void (*task_handler)(void *);	/* Function pointer to task handler */
+	void *arg;						/* Argument passed to the task handler */
+	uint32_t stack_size;			/* Size of the task stack in bytes */
+	struct TCB *next;				/* Next TCB in the ready list of the same priority (Or wait queue) */
+	struct TCB *prev;				/* Previous TCB in the ready list of the same priority (Or wait queue) */
+	struct TCB *sleep_next;			/* Next TCB in the sleep queue (Later deadline) */
+	struct TCB *sleep_prev;			/* Previous TCB in the sleep queue (Earlier deadline) */
+	wait_queue_t *wait_queue;		/* Wait queue the task is in (WAITING; NULL for a notification) */
+	int32_t wait_result;			/* Outcome of the last wait (E_OK, E_TIMEOUT) */
+	void *wait_data;				/* Data handed over with the wait (e.g., a message) */
+	struct mutex *held_mutexes;		/* Mutexes owned by the task (Priority inheritance) */
+	struct mutex *waiting_mutex;	/* Mutex the task is WAITING on, if any */
+	uint32_t notify_value;			/* Notification word (task_notify()) */
+	uint8_t notify_state;			/* NOTIFY_IDLE, NOTIFY_PENDING or NOTIFY_WAITING */
+#if SCHED_EDF
+	uint32_t deadline;				/* Relative deadline in ticks (NO_DEADLINE: None) */
+	uint32_t abs_deadline;			/* Tick by which the current release must complete */
+#endif
+} TCB_t;
+
+/* Kernel state shared with the port */
+extern TCB_t *curr_tcb;
+extern TCB_t *next_tcb;
+
+/* Kernel hooks (Called by the port) */
+void kernel_tick(void);
+
+/* Kernel internals (Used by the kernel objects, e.g., sem.c; must be called
+   in a critical section) */
+void schedule(void);
+void kernel_wait(wait_queue_t *wait_queue, uint32_t timeout);
+TCB_t *kernel_wake(wait_queue_t *wait_queue, int32_t result);
+void kernel_wake_task(TCB_t *tcb, int32_t result);
+void kernel_set_priority(TCB_t *tcb, uint8_t priority);
 
 /* Kernel interface */
 void start_kernel(void);
-void create_tasks(void (*t1_handler)(void),
-				  void (*t2_handler)(void),
-				  void (*t3_handler)(void),
-				  void (*t4_handler)(void));
+TCB_t *task_create(void (*task_handler)(void *), void *arg,
+				   uint32_t stack_size, uint8_t priority);
 void block_task(uint32_t tick_count);
+void task_delay_until(uint32_t *last_wake, uint32_t period);
+uint32_t get_tick_count(void);
+int task_notify(TCB_t *task, uint32_t value, uint8_t action);
+int task_notify_from_isr(TCB_t *task, uint32_t value, uint8_t action);
+int task_notify_wait(uint32_t clear_bits, uint32_t *value, uint32_t timeout);
+int task_is_valid(TCB_t *task);
+#if SCHED_EDF
+int task_set_deadline(TCB_t *task, uint32_t deadline);
+#endif
+#if STACK_CHECK
+uint32_t task_stack_high_water(TCB_t *task);
+#endif
 
 #endif /* kernel.h */
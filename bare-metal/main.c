@@ -9,15 +9,37 @@
 #include <stdio.h>
 #include "led.h"
 #include "kernel.h"
+#include "timer.h"
+
+/* Blink periods (Ticks between two toggles) */
+#define GREEN_PERIOD		1000U
+#define ORANGE_PERIOD		500U
+#define BLUE_PERIOD			250U
+#define RED_PERIOD			125U
 
 /* Function prototypes */
-void task1_handler(void);		/* Task 1 */
-void task2_handler(void);		/* Task 2 */
-void task3_handler(void);		/* Task 3 */
-void task4_handler(void);		/* Task 4 */
+void led_timer_callback(void *arg);	/* Toggles one LED */
 
 extern void initialise_monitor_handles(void);	/* Semihosting init function */
 
+/* One LED blinker: A timer instead of a task, so the four of them share the
+   timer daemon's stack */
+typedef struct
+{
+	soft_timer_t timer;
+	void (*toggle)(void);			/* LED driver function */
+	uint32_t period;				/* Ticks between two toggles */
+	const char *name;
+} blinker_t;
+
+blinker_t blinkers[] =
+{
+	{ .toggle = led_green_toggle,	.period = GREEN_PERIOD,		.name = "Green" },
+	{ .toggle = led_orange_toggle,	.period = ORANGE_PERIOD,	.name = "Orange" },
+	{ .toggle = led_blue_toggle,	.period = BLUE_PERIOD,		.name = "Blue" },
+	{ .toggle = led_red_toggle,		.period = RED_PERIOD,		.name = "Red" },
+};
+
 int main(void)
 {
 	/* Initialize Semihosting for message printing feature */
@@ -28,8 +50,14 @@ int main(void)
 	/* Initialize LEDs */
 	led_init();
 
-	/* Create tasks */
-	create_tasks(task1_handler, task2_handler, task3_handler, task4_handler);
+	/* Start the timer service and one auto-reload timer per LED */
+	soft_timer_service_init();
+
+	for (uint32_t i = 0; i < (sizeof(blinkers) / sizeof(blinkers[0])); i++)
+	{
+		soft_timer_init(&blinkers[i].timer, led_timer_callback, &blinkers[i]);
+		soft_timer_start(&blinkers[i].timer, blinkers[i].period, blinkers[i].period);
+	}
 
 	/* Start kernel*/
 	start_kernel();
@@ -39,77 +67,16 @@ int main(void)
 } /* End of main */
 
 /* 
- * task1_handler()
- * Brief	: Toggles green LED every 1000 ms
- * Param	: None
- * Retval	: None
- * Note		: N/A
- */
-void task1_handler(void)
-{
-	while (1)
-	{
-		printf("Task 1\n");
-		led_green_on();
-		block_task(1000);
-		led_green_off();
-		block_task(1000);
-	}
-} /* End of task1_handler */
-
-/* 
- * task2_handler()
- * Brief	: Toggles orange LED every 500 ms
- * Param	: None
+ * led_timer_callback()
+ * Brief	: Toggles the LED of a blinker
+ * Param	: @arg - Blinker (blinker_t) whose timer expired
  * Retval	: None
- * Note		: N/A
+ * Note		: Runs in the timer daemon task.
  */
-void task2_handler(void)
+void led_timer_callback(void *arg)
 {
-	while (1)
-	{
-		printf("Task 2\n");
-		led_orange_on();
-		block_task(500);
-		led_orange_off();
-		block_task(500);
-	}
-} /* End of task2_handler */
+	blinker_t *blinker = arg;
 
-/* 
- * task3_handler()
- * Brief	: Toggles blue LED every 250 ms
- * Param	: None
- * Retval	: None
- * Note		: N/A
- */
-void task3_handler(void)
-{
-	while (1)
-	{
-		printf("Task 3\n");
-		led_blue_on();
-		block_task(250);
-		led_blue_off();
-		block_task(250);
-	}
-} /* End of task3_handler */
-
-/* 
- * task4_handler()
- * Brief	: Toggles red LED every 250 ms
- * Param	: None
- * Retval	: None
- * Note		: N/A
- */
-void task4_handler(void)
-{
-	while (1)
-	{
-		printf("Task 4\n");
-		led_red_on();
-		block_task(125);
-		led_red_off();
-		block_task(125);
-	}
-} /* End of task4_handler */
+	printf("%s\n", blinker->name);
+	blinker->toggle();
+} /* End of led_timer_callback */
@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * File		: mempool.c
+ * Brief	: Implementation of fixed-block memory pools
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * A pool hands out blocks of a single size from storage set aside at link
+ * time (MEMPOOL_DEFINE(), .mempool in stm32_ls.ld), instead of newlib malloc()
+ * on top of _sbrk():
+ *
+ * 	- The free blocks form a singly-linked list threaded through the blocks
+ * 	  themselves, so mempool_alloc() and mempool_free() are O(1) and need no
+ * 	  memory of their own.
+ * 	- All blocks have the same size, so the pool cannot fragment, however long
+ * 	  the system runs.
+ * 	- Both run in a short critical section and never block: They can be
+ * 	  called from tasks and from ISRs (At or below the kernel interrupt
+ * 	  priority).
+ *
+ * Each pool keeps its lowest number of free blocks, so that the storage can be
+ * sized from a long run (mempool_get_stats()).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "mempool.h"
+#include "svc.h"
+
+/*
+ * mempool_init()
+ * Brief	: Initializes a pool with all of its blocks free
+ * Param	: @pool - Pool to initialize
+ * 			: @storage - Storage for the blocks (8-byte aligned, at least
+ * 						 MEMPOOL_BLOCK_SIZE(block_size) * num_blocks bytes)
+ * 			: @block_size - Bytes per block (Rounded up by MEMPOOL_BLOCK_SIZE())
+ * 			: @num_blocks - Number of blocks
+ * Retval	: E_OK on success, E_INVALID on invalid arguments
+ * Note		: Must not be called while blocks of the pool are in use.
+ */
+int mempool_init(mempool_t *pool, void *storage, uint32_t block_size, uint32_t num_blocks)
+{
+	uint8_t *block;
+
+	if ((pool == NULL) || (storage == NULL) || (block_size == 0) || (num_blocks == 0) ||
+		(((uintptr_t)storage & (MEMPOOL_ALIGN - 1U)) != 0))
+		return E_INVALID;
+
+	pool->block_size = MEMPOOL_BLOCK_SIZE(block_size);
+	pool->num_blocks = num_blocks;
+	pool->start = (uint8_t *)storage;
+	pool->end = pool->start + (pool->block_size * num_blocks);
+
+	/* Link the blocks in address order */
+	for (block = pool->start; block < (pool->end - pool->block_size); block += pool->block_size)
+		*(void **)block = block + pool->block_size;
+
+	*(void **)block = NULL;
+
+	pool->free_list = pool->start;
+	pool->num_free = num_blocks;
+	pool->min_free = num_blocks;
+	pool->num_fail = 0;
+
+	return E_OK;
+} /* End of mempool_init */
+
+/*
+ * mempool_alloc()
+ * Brief	: Allocates a block from a pool
+ * Param	: @pool - Pool to allocate from
+ * Retval	: Pointer to the block, NULL if the pool is empty
+ * Note		: O(1); never blocks. The block content is undefined.
+ */
+void *mempool_alloc(mempool_t *pool)
+{
+	void *block;
+
+	if (!IS_PRIVILEGED())
+		return (void *)SYSCALL(SYS_MEMPOOL_ALLOC, pool, 0, 0, 0);
+
+	ENTER_CRITICAL();
+
+	block = pool->free_list;
+
+	if (block == NULL)
+	{
+		pool->num_fail++;
+		EXIT_CRITICAL();
+		return NULL;
+	}
+
+	pool->free_list = *(void **)block;
+
+	if (--pool->num_free < pool->min_free)
+		pool->min_free = pool->num_free;
+
+	EXIT_CRITICAL();
+
+	return block;
+} /* End of mempool_alloc */
+
+/*
+ * mempool_free()
+ * Brief	: Returns a block to its pool
+ * Param	: @pool - Pool the block was allocated from
+ * 			: @block - Block returned by mempool_alloc()
+ * Retval	: E_OK on success, E_INVALID if block is not a block of pool
+ * Note		: O(1); never blocks. Freeing a block twice is not detected.
+ */
+int mempool_free(mempool_t *pool, void *block)
+{
+	uint8_t *addr = (uint8_t *)block;
+
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_MEMPOOL_FREE, pool, block, 0, 0);
+
+	if ((addr < pool->start) || (addr >= pool->end) ||
+		(((uint32_t)(addr - pool->start) % pool->block_size) != 0))
+		return E_INVALID;
+
+	ENTER_CRITICAL();
+
+	*(void **)block = pool->free_list;
+	pool->free_list = block;
+	pool->num_free++;
+
+	EXIT_CRITICAL();
+
+	return E_OK;
+} /* End of mempool_free */
+
+/*
+ * mempool_get_stats()
+ * Brief	: Reads the usage statistics of a pool
+ * Param	: @pool - Pool
+ * 			: @stats - Where to copy the statistics to
+ * Retval	: None
+ * Note		: max_used is the high-water mark since mempool_init(); a pool
+ * 			  whose max_used stays well below num_blocks can be made smaller.
+ */
+void mempool_get_stats(mempool_t *pool, mempool_stats_t *stats)
+{
+	if (!IS_PRIVILEGED())
+	{
+		(void)SYSCALL(SYS_MEMPOOL_GET_STATS, pool, stats, 0, 0);
+		return;
+	}
+
+	ENTER_CRITICAL();
+
+	stats->block_size = pool->block_size;
+	stats->num_blocks = pool->num_blocks;
+	stats->num_used = pool->num_blocks - pool->num_free;
+	stats->max_used = pool->num_blocks - pool->min_free;
+	stats->num_fail = pool->num_fail;
+
+	EXIT_CRITICAL();
+} /* End of mempool_get_stats */
@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * File		: mempool.h
+ * Brief	: Interface for fixed-block memory pools
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/* Blocks are 8-byte aligned (Any C type, including double and uint64_t) and
+   at least big enough to hold the free list link */
+#define MEMPOOL_ALIGN				8U
+#define MEMPOOL_BLOCK_SIZE(size) \
+	(((((size) < sizeof(void *)) ? sizeof(void *) : (size)) + (MEMPOOL_ALIGN - 1U)) & \
+	 ~(MEMPOOL_ALIGN - 1U))
+
+/* Fixed-block memory pool; the blocks are carved out of storage handed to
+   mempool_init(), normally defined with MEMPOOL_DEFINE() */
+typedef struct
+{
+	void *free_list;				/* First free block; each free block links to the next */
+	uint8_t *start;					/* First block */
+	uint8_t *end;					/* One past the last block */
+	uint32_t block_size;			/* Bytes per block (MEMPOOL_BLOCK_SIZE()) */
+	uint32_t num_blocks;			/* Capacity */
+	uint32_t num_free;				/* Blocks not allocated */
+	uint32_t min_free;				/* Lowest num_free so far (High-water mark) */
+	uint32_t num_fail;				/* mempool_alloc() calls that found the pool empty */
+} mempool_t;
+
+/* Statistics of a pool (mempool_get_stats()) */
+typedef struct
+{
+	uint32_t block_size;			/* Bytes per block */
+	uint32_t num_blocks;			/* Capacity */
+	uint32_t num_used;				/* Blocks allocated now */
+	uint32_t max_used;				/* Most blocks ever allocated at once */
+	uint32_t num_fail;				/* Allocations that failed */
+} mempool_stats_t;
+
+/*
+ * MEMPOOL_DEFINE()
+ * Defines a pool and its storage for num_blocks blocks of block_size bytes.
+ * The storage goes to the .mempool section of stm32_ls.ld, which is not
+ * cleared by the startup code and is accounted for separately from .bss in
+ * final.map. The pool must still be initialized with:
+ *
+ * 	mempool_init(&name, name##_storage, block_size, num_blocks);
+ */
+#define MEMPOOL_DEFINE(name, block_size, num_blocks) \
+	uint64_t name##_storage[(MEMPOOL_BLOCK_SIZE(block_size) * (num_blocks)) / sizeof(uint64_t)] \
+		SECTION(".mempool"); \
+	mempool_t name
+
+/* Memory pool interface */
+int mempool_init(mempool_t *pool, void *storage, uint32_t block_size, uint32_t num_blocks);
+void *mempool_alloc(mempool_t *pool);
+int mempool_free(mempool_t *pool, void *block);
+void mempool_get_stats(mempool_t *pool, mempool_stats_t *stats);
+
+#endif /* mempool.h */
@@ -0,0 +1,232 @@
+/*******************************************************************************
+ * File		: msgq.c
+ * Brief	: Implementation of zero-copy message queues
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * Only pointers to message buffers go through the queue, never the message
+ * contents, and every send transfers the ownership of the buffer:
+ *
+ * 	- After a successful send, the sender must not touch the buffer anymore.
+ * 	  After a failed one (E_TIMEOUT, E_FULL), it still owns it.
+ * 	- The receiver owns the buffer it got, and is the one to free it (e.g.,
+ * 	  back to the pool it was allocated from) or to send it on.
+ *
+ * Whenever a task is waiting on the other side, the pointer is handed to it
+ * directly through its TCB (wait_data), without going through the slots.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "msgq.h"
+#include "svc.h"
+
+/*
+ * msgq_put()
+ * Brief	: Hands a message to a waiting receiver, or queues it
+ * Param	: @q - Message queue
+ * 			: @msg - Message buffer
+ * Retval	: E_OK on success, E_FULL if the queue is full
+ * Note		: Must be called in a critical section.
+ */
+static int msgq_put(msgq_t *q, void *msg)
+{
+	TCB_t *tcb = kernel_wake(&q->recv_queue, E_OK);
+
+	if (tcb != NULL)
+	{
+		tcb->wait_data = msg;
+		schedule();
+		return E_OK;
+	}
+
+	if (q->count == q->num_slots)
+		return E_FULL;
+
+	q->slots[(q->read + q->count) % q->num_slots] = msg;
+	q->count++;
+
+	return E_OK;
+} /* End of msgq_put */
+
+/*
+ * msgq_get()
+ * Brief	: Dequeues the oldest message, and lets the first blocked sender
+ * 			  queue its message in the freed slot
+ * Param	: @q - Message queue
+ * 			: @msg - Where to store the message buffer
+ * Retval	: E_OK on success, E_TIMEOUT if the queue is empty
+ * Note		: Must be called in a critical section.
+ */
+static int msgq_get(msgq_t *q, void **msg)
+{
+	TCB_t *tcb;
+
+	if (q->count == 0)
+		return E_TIMEOUT;
+
+	*msg = q->slots[q->read];
+	q->read = (q->read + 1U) % q->num_slots;
+	q->count--;
+
+	tcb = kernel_wake(&q->send_queue, E_OK);
+	if (tcb != NULL)
+	{
+		q->slots[(q->read + q->count) % q->num_slots] = tcb->wait_data;
+		q->count++;
+		schedule();
+	}
+
+	return E_OK;
+} /* End of msgq_get */
+
+/*
+ * msgq_init()
+ * Brief	: Initializes an empty message queue
+ * Param	: @q - Message queue to initialize
+ * 			: @slots - Array of num_slots pointers
+ * 			: @num_slots - Capacity of the queue
+ * 			: @order - Order blocked senders and receivers are served in
+ * 					   (WAIT_FIFO or WAIT_PRIORITY)
+ * Retval	: E_OK on success, E_INVALID on invalid arguments
+ * Note		: Must not be called while the queue is in use.
+ */
+int msgq_init(msgq_t *q, void **slots, uint32_t num_slots, uint8_t order)
+{
+	if ((q == NULL) || (slots == NULL) || (num_slots == 0) ||
+		((order != WAIT_FIFO) && (order != WAIT_PRIORITY)))
+	{
+		return E_INVALID;
+	}
+
+	q->slots = slots;
+	q->num_slots = num_slots;
+	q->count = 0;
+	q->read = 0;
+	q->recv_queue.head = NULL;
+	q->recv_queue.order = order;
+	q->send_queue.head = NULL;
+	q->send_queue.order = order;
+
+	return E_OK;
+} /* End of msgq_init */
+
+/*
+ * msgq_send()
+ * Brief	: Sends a message buffer, waiting for room if the queue is full
+ * Param	: @q - Message queue
+ * 			: @msg - Message buffer (Its ownership goes to the receiver)
+ * 			: @timeout - Maximum number of ticks to wait (NO_WAIT: Do not wait,
+ * 						 WAIT_FOREVER: No limit)
+ * Retval	: E_OK on success, E_FULL if the queue is full with NO_WAIT,
+ * 			  E_TIMEOUT if no room was made in time
+ * Note		: A waiting receiver gets the buffer directly and may preempt the
+ * 			  caller right away.
+ */
+int msgq_send(msgq_t *q, void *msg, uint32_t timeout)
+{
+	int ret;
+
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_MSGQ_SEND, q, msg, timeout, 0);
+
+	ENTER_CRITICAL();
+
+	ret = msgq_put(q, msg);
+
+	if ((ret != E_FULL) || (timeout == NO_WAIT))
+	{
+		EXIT_CRITICAL();
+		return ret;
+	}
+
+	/* The receiver that frees a slot queues the message on our behalf */
+	curr_tcb->wait_data = msg;
+	kernel_wait(&q->send_queue, timeout);
+
+	/* Switched out here, until the message is queued or timed out */
+	EXIT_CRITICAL();
+
+	return curr_tcb->wait_result;
+} /* End of msgq_send */
+
+/*
+ * msgq_receive()
+ * Brief	: Receives the oldest message buffer, waiting for one if the queue
+ * 			  is empty
+ * Param	: @q - Message queue
+ * 			: @msg - Where to store the message buffer (Now owned by the caller)
+ * 			: @timeout - Maximum number of ticks to wait (NO_WAIT: Do not wait,
+ * 						 WAIT_FOREVER: No limit)
+ * Retval	: E_OK on success, E_TIMEOUT if no message arrived in time
+ * Note		: N/A
+ */
+int msgq_receive(msgq_t *q, void **msg, uint32_t timeout)
+{
+	int ret;
+
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_MSGQ_RECEIVE, q, msg, timeout, 0);
+
+	ENTER_CRITICAL();
+
+	ret = msgq_get(q, msg);
+
+	if ((ret == E_OK) || (timeout == NO_WAIT))
+	{
+		EXIT_CRITICAL();
+		return ret;
+	}
+
+	kernel_wait(&q->recv_queue, timeout);
+
+	/* Switched out here, until a sender hands over a message or timed out */
+	EXIT_CRITICAL();
+
+	ret = curr_tcb->wait_result;
+	if (ret == E_OK)
+		*msg = curr_tcb->wait_data;
+
+	return ret;
+} /* End of msgq_receive */
+
+/*
+ * msgq_send_from_isr()
+ * Brief	: Posts a message buffer from an ISR
+ * Param	: @q - Message queue
+ * 			: @msg - Message buffer (Its ownership goes to the receiver)
+ * Retval	: E_OK on success, E_FULL if the queue is full
+ * Note		: Never blocks. A receiver woken up by it runs as soon as the ISR
+ * 			  returns, through PendSV.
+ */
+int msgq_send_from_isr(msgq_t *q, void *msg)
+{
+	return msgq_send(q, msg, NO_WAIT);
+} /* End of msgq_send_from_isr */
+
+/*
+ * msgq_receive_from_isr()
+ * Brief	: Takes a message buffer from an ISR (e.g., to recycle buffers)
+ * Param	: @q - Message queue
+ * 			: @msg - Where to store the message buffer (Now owned by the caller)
+ * Retval	: E_OK on success, E_TIMEOUT if the queue is empty
+ * Note		: Never blocks.
+ */
+int msgq_receive_from_isr(msgq_t *q, void **msg)
+{
+	return msgq_receive(q, msg, NO_WAIT);
+} /* End of msgq_receive_from_isr */
+
+/*
+ * msgq_count()
+ * Brief	: Returns the number of queued messages
+ * Param	: @q - Message queue
+ * Retval	: Number of messages
+ * Note		: N/A
+ */
+uint32_t msgq_count(msgq_t *q)
+{
+	return q->count;
+} /* End of msgq_count */
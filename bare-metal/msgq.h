@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * File		: msgq.h
+ * Brief	: Interface for zero-copy message queues
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef MSGQ_H
+#define MSGQ_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/* Message queue of pointers to message buffers; statically allocated by the
+   application along with its slots (num_slots pointers) */
+typedef struct
+{
+	void **slots;					/* Queued messages (Circular) */
+	uint32_t num_slots;				/* Capacity */
+	uint32_t count;					/* Number of queued messages */
+	uint32_t read;					/* Slot of the oldest message */
+	wait_queue_t recv_queue;		/* Tasks blocked in msgq_receive() (Queue empty) */
+	wait_queue_t send_queue;		/* Tasks blocked in msgq_send() (Queue full) */
+} msgq_t;
+
+/* Message queue interface */
+int msgq_init(msgq_t *q, void **slots, uint32_t num_slots, uint8_t order);
+int msgq_send(msgq_t *q, void *msg, uint32_t timeout);
+int msgq_receive(msgq_t *q, void **msg, uint32_t timeout);
+int msgq_send_from_isr(msgq_t *q, void *msg);
+int msgq_receive_from_isr(msgq_t *q, void **msg);
+uint32_t msgq_count(msgq_t *q);
+
+#endif /* msgq.h */
@@ -0,0 +1,237 @@
+/*******************************************************************************
+ * File		: mutex.c
+ * Brief	: Implementation of recursive mutexes with priority inheritance
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * Priority inheritance: The owner of a mutex always runs at the highest
+ * priority among its own base priority and the tasks waiting on any mutex it
+ * holds. Since the wait queues are WAIT_PRIORITY, that is the head of each
+ * queue. The owner's priority is recomputed whenever a task starts or stops
+ * waiting on one of its mutexes, and whenever it releases one. If the owner
+ * itself waits on another mutex, the change is passed on down the chain of
+ * owners (Transitive inheritance), so a low priority owner cannot keep a high
+ * priority task waiting behind medium priority tasks.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "mutex.h"
+#include "svc.h"
+
+/*
+ * mutex_update_priority()
+ * Brief	: Recomputes the inherited priority of a task and passes the change
+ * 			  on to the owner of the mutex it is waiting on
+ * Param	: @tcb - TCB of a mutex owner
+ * Retval	: None
+ * Note		: Must be called in a critical section. The caller calls
+ * 			  schedule() afterwards.
+ */
+static void mutex_update_priority(TCB_t *tcb)
+{
+	mutex_t *mutex;
+	TCB_t *waiter;
+	uint8_t priority;
+
+	while (tcb != NULL)
+	{
+		/* Highest of its base priority and its mutexes' first waiters */
+		priority = tcb->base_priority;
+
+		for (mutex = tcb->held_mutexes; mutex != NULL; mutex = mutex->next_held)
+		{
+			waiter = mutex->wait_queue.head;
+
+			if ((waiter != NULL) && (waiter->priority > priority))
+				priority = waiter->priority;
+		}
+
+		if (priority == tcb->priority)
+			break;
+
+		kernel_set_priority(tcb, priority);
+
+		/* The owner of the mutex this task waits on may inherit it in turn */
+		if ((tcb->state != WAITING) || (tcb->waiting_mutex == NULL))
+			break;
+
+		tcb = tcb->waiting_mutex->owner;
+	}
+} /* End of mutex_update_priority */
+
+/*
+ * mutex_acquire()
+ * Brief	: Makes a task the owner of a free mutex
+ * Param	: @mutex - Mutex to be owned
+ * 			: @tcb - TCB of the new owner
+ * Retval	: None
+ * Note		: Must be called in a critical section.
+ */
+static void mutex_acquire(mutex_t *mutex, TCB_t *tcb)
+{
+	mutex->owner = tcb;
+	mutex->lock_count = 1;
+	mutex->next_held = tcb->held_mutexes;
+	tcb->held_mutexes = mutex;
+} /* End of mutex_acquire */
+
+/*
+ * mutex_release()
+ * Brief	: Removes a mutex from the list of mutexes held by its owner
+ * Param	: @mutex - Mutex being released
+ * Retval	: None
+ * Note		: Must be called in a critical section.
+ */
+static void mutex_release(mutex_t *mutex)
+{
+	mutex_t **link = &mutex->owner->held_mutexes;
+
+	while (*link != mutex)
+		link = &(*link)->next_held;
+
+	*link = mutex->next_held;
+	mutex->next_held = NULL;
+	mutex->owner = NULL;
+	mutex->lock_count = 0;
+} /* End of mutex_release */
+
+/*
+ * mutex_init()
+ * Brief	: Initializes a mutex in the unlocked state
+ * Param	: @mutex - Mutex to initialize
+ * Retval	: E_OK on success, E_INVALID if mutex is NULL
+ * Note		: Must not be called while tasks may be using the mutex.
+ */
+int mutex_init(mutex_t *mutex)
+{
+	if (mutex == NULL)
+		return E_INVALID;
+
+	mutex->owner = NULL;
+	mutex->lock_count = 0;
+	mutex->wait_queue.head = NULL;
+	mutex->wait_queue.order = WAIT_PRIORITY;
+	mutex->next_held = NULL;
+
+	return E_OK;
+} /* End of mutex_init */
+
+/*
+ * mutex_lock()
+ * Brief	: Locks a mutex, waiting for its owner to unlock it if needed
+ * Param	: @mutex - Mutex to lock
+ * 			: @timeout - Maximum number of ticks to wait (NO_WAIT: Do not wait,
+ * 						 WAIT_FOREVER: No limit)
+ * Retval	: E_OK if the mutex is now held by the caller, E_TIMEOUT if it was
+ * 			  not unlocked in time
+ * Note		: Recursive: The owner may lock it again, and must unlock it as
+ * 			  many times. While the caller waits, the owner inherits its
+ * 			  priority.
+ */
+int mutex_lock(mutex_t *mutex, uint32_t timeout)
+{
+	int ret;
+
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_MUTEX_LOCK, mutex, timeout, 0, 0);
+
+	ENTER_CRITICAL();
+
+	if (mutex->owner == NULL)
+	{
+		mutex_acquire(mutex, curr_tcb);
+		EXIT_CRITICAL();
+		return E_OK;
+	}
+
+	if (mutex->owner == curr_tcb)
+	{
+		mutex->lock_count++;
+		EXIT_CRITICAL();
+		return E_OK;
+	}
+
+	if (timeout == NO_WAIT)
+	{
+		EXIT_CRITICAL();
+		return E_TIMEOUT;
+	}
+
+	curr_tcb->waiting_mutex = mutex;
+	kernel_wait(&mutex->wait_queue, timeout);
+
+	/* Lend our priority to the owner (And to whoever it waits on) */
+	mutex_update_priority(mutex->owner);
+	schedule();
+
+	/* Switched out here, until handed the mutex or timed out */
+	EXIT_CRITICAL();
+
+	ret = curr_tcb->wait_result;
+
+	if (ret != E_OK)
+	{
+		/* Timed out: Take back the priority lent to the owner */
+		ENTER_CRITICAL();
+		curr_tcb->waiting_mutex = NULL;
+		if (mutex->owner != NULL)
+			mutex_update_priority(mutex->owner);
+		schedule();
+		EXIT_CRITICAL();
+	}
+
+	return ret;
+} /* End of mutex_lock */
+
+/*
+ * mutex_unlock()
+ * Brief	: Unlocks a mutex held by the caller
+ * Param	: @mutex - Mutex to unlock
+ * Retval	: E_OK on success, E_INVALID if the caller does not own the mutex
+ * Note		: The last unlock hands the mutex directly to the highest priority
+ * 			  waiter, and drops whatever priority the caller inherited through
+ * 			  it.
+ */
+int mutex_unlock(mutex_t *mutex)
+{
+	TCB_t *tcb;
+
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_MUTEX_UNLOCK, mutex, 0, 0, 0);
+
+	ENTER_CRITICAL();
+
+	if (mutex->owner != curr_tcb)
+	{
+		EXIT_CRITICAL();
+		return E_INVALID;
+	}
+
+	if (--mutex->lock_count > 0)
+	{
+		EXIT_CRITICAL();
+		return E_OK;
+	}
+
+	mutex_release(mutex);
+
+	/* Hand it over to the first waiter, which may inherit from the others */
+	tcb = kernel_wake(&mutex->wait_queue, E_OK);
+	if (tcb != NULL)
+	{
+		tcb->waiting_mutex = NULL;
+		mutex_acquire(mutex, tcb);
+		mutex_update_priority(tcb);
+	}
+
+	/* Back to the priority we are still entitled to */
+	mutex_update_priority(curr_tcb);
+	schedule();
+
+	EXIT_CRITICAL();
+
+	return E_OK;
+} /* End of mutex_unlock */
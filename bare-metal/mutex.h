@@ -0,0 +1,28 @@
+/*******************************************************************************
+ * File		: mutex.h
+ * Brief	: Interface for recursive mutexes with priority inheritance
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/* Mutex; statically allocated by the application */
+typedef struct mutex
+{
+	TCB_t *owner;					/* Task holding the mutex (NULL: Unlocked) */
+	uint32_t lock_count;			/* Number of nested locks by the owner */
+	wait_queue_t wait_queue;		/* Tasks blocked in mutex_lock() (WAIT_PRIORITY) */
+	struct mutex *next_held;		/* Next mutex held by the same owner */
+} mutex_t;
+
+/* Mutex interface (Tasks only; not to be used from an ISR) */
+int mutex_init(mutex_t *mutex);
+int mutex_lock(mutex_t *mutex, uint32_t timeout);
+int mutex_unlock(mutex_t *mutex);
+
+#endif /* mutex.h */
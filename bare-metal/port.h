@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * File		: port.h
+ * Brief	: Interface between the RTOS kernel and the architecture port
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef PORT_H
+#define PORT_H
+
+#include <stdint.h>
+
+/*
+ * The kernel (kernel.c) only ever touches the processor through this interface,
+ * so the same scheduler and blocking code runs on the target and on a host:
+ *
+ * 	port_cm4.c		: ARM Cortex-M4 (STM32F407); SysTick, PendSV, BASEPRI, SVC
+ * 	port_posix.c	: Linux/POSIX simulation (Build with -DPORT_POSIX); SIGALRM,
+ * 					  ucontext, a software interrupt mask
+ *
+ * Each port header provides the following macros, plus the constants used by
+ * the kernel configuration in kernel.h (MIN_STACK_SIZE, MAX_IDLE_TICKS):
+ *
+ * 	ENTER_CRITICAL()		: Mask the interrupts that may call into the kernel;
+ * 							  nests, and can be used from those interrupts
+ * 	EXIT_CRITICAL()			: Leave it; the outermost exit unmasks them, and a
+ * 							  pended context switch happens there
+ * 	DISABLE_INTERRUPTS()	: Mask all interrupts (Does not nest). Only for
+ * 							  short sections that must not be preempted at all
+ * 							  (e.g., the idle task going to sleep)
+ * 	ENABLE_INTERRUPTS()		: Unmask them
+ * 	PEND_CONTEXT_SWITCH()	: Request a switch from curr_tcb to next_tcb
+ * 	CYCLE_COUNT()			: Free-running 32-bit timestamp (KERNEL_STATS)
+ * 	MEMORY_BARRIER()		: Complete all prior memory accesses before any that
+ * 							  follow (Lock-free data structures, e.g., ringbuf.c)
+ * 	IS_PRIVILEGED()			: Non-zero if the caller may run kernel code directly
+ * 	SYSCALL(num, a0-a3)		: Run kernel service num (svc.h) with the caller's
+ * 							  arguments at the kernel's privilege level
+ * 	SYSCALL5(num, a0-a4)	: Same for a service with five arguments
+ * 	TASK_CONTROL			: Initial privilege of a task (TCB control)
+ * 	SECTION(name)			: Place a variable in a linker section (e.g., for
+ * 							  mempool.h); may be ignored by the port
+ * 	KERNEL_DATA				: Placement of the kernel state, TCBs and task
+ * 							  stacks (e.g., a faster RAM, or one unprivileged
+ * 							  tasks can't access); may be empty
+ * 	MPU_ENABLED				: Non-zero if the port protects the task stacks with
+ * 							  an MPU (port_mpu_stack_regions())
+ * 	STACK_GUARD_SIZE		: Bytes at the bottom of each stack the task must
+ * 							  not use (MPU guard); may be 0
+ * 	STACK_SIZE_ROUND(size)	: Task stack size actually carved for size bytes
+ * 	STACK_ALIGN(size)		: Alignment of a task stack of that (rounded) size
+ */
+#ifdef PORT_POSIX
+#include "port_posix.h"
+#else
+#include "port_cm4.h"
+#endif
+
+/* Port interface (Called by the kernel) */
+void port_init(void);
+uintptr_t port_init_stack(uintptr_t stack_base, uint32_t stack_size,
+						  void (*task_handler)(void *), void *arg);
+uint32_t port_idle(uint32_t idle_ticks);
+void port_start_first_task(void);
+uint32_t port_access_ok(uintptr_t addr, uint32_t size);
+#if MPU_ENABLED
+void port_mpu_stack_regions(uintptr_t stack_base, uint32_t stack_size, uint32_t *regions);
+#endif
+
+#endif /* port.h */
@@ -0,0 +1,708 @@
+/*******************************************************************************
+ * File		: port_cm4.c
+ * Brief	: ARM Cortex-M4 (STM32F407) port of the RTOS kernel
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include "kernel.h"
+#include "svc.h"
+
+/* Depth of the current critical section. Only the code running at the lowest
+   kernel level touches it at a time: A task, or a kernel aware ISR that
+   preempted a task outside of any critical section. */
+volatile uint32_t critical_nesting KERNEL_DATA;
+
+/* Scheduler (Handler mode, MSP) stack; main() keeps the one at SRAM_END */
+uint64_t sched_stack[SIZE_SCHED_STACK / sizeof(uint64_t)] KERNEL_DATA;
+
+/*
+ * init_systick_timer()
+ * Brief	: Initializes SysTick Timer
+ * Param	: @tick_hz
+ * Retval	: None
+ * Note		: N/A
+ */
+void init_systick_timer(uint32_t tick_hz)
+{
+	uint32_t start_val = (SYSTICK_TIM_CLK / tick_hz) - 1;
+
+	/* Clear the least significant 24 bits in the SYST_RVR */
+	SYST_RVR &= ~0x00FFFFFF;
+
+	/* Load the counter start value into SYST_RVR */
+	SYST_RVR |= start_val;
+
+	/* Configure SYST_CSR */
+	SYST_CSR |= (TICKINT | CLKSOURCE | ENABLE);
+		/* TICKINT	: Enable SysTick exception request */
+		/* CLKSOURCE: Specify clock source; processor clock source */
+		/* ENABLE	: Enable counter */
+} /* End of init_systick_timer */
+
+/* 
+ * port_init_stack()
+ * Brief	: Builds the initial dummy context of a task on its stack, as if the
+ * 			  task had been switched out by PendSV_Handler()
+ * Param	: @stack_base - Lowest address of the task stack
+ * 			: @stack_size - Stack size in bytes (Multiple of 8)
+ * 			: @task_handler - Pointer to task handler
+ * 			: @arg - Argument passed to the task handler (in r0)
+ * Retval	: Initial PSP value of the task
+ * Note		: N/A
+ */
+uintptr_t port_init_stack(uintptr_t stack_base, uint32_t stack_size,
+						  void (*task_handler)(void *), void *arg)
+{
+	/* ARM Cortex-M4 processor stack model: Full-Descending */
+
+	uint32_t *p_psp = (uint32_t *)(stack_base + stack_size);
+
+	/* Create initial dummy context */
+
+	/* xPSR */
+	p_psp--;	/* To stay consistent with FD model: Decrement -> store */
+	*p_psp = DUMMY_XPSR;	/* 0x01000000; Set T-bit to specify Thumb ISA */
+
+	/* PC */
+	p_psp--;
+	*p_psp = (uint32_t)task_handler;
+		/* Since ARM Cortex-M4 processor operates only in Thumb state, it's 
+		   also a good practice to check if the address of all task handlers
+		   is odd. */
+
+	/* LR */
+	p_psp--;
+	*p_psp = 0xFFFFFFFD;
+		/* EXC_RETURN[31:0] - Exception return behavior
+		   0xFFFFFFFD: Return to Thread mode, exception return uses 
+		   non-floating point state from the PSP and execution uses PSP 
+		   after return. -> Matches our environment! */
+
+	/* r12, r3, r2, r1 */
+	p_psp -= 4;
+
+	/* r0; By AAPCS, the first argument of the task handler */
+	p_psp--;
+	*p_psp = (uint32_t)arg;
+
+#if FPU_ENABLED
+	/* EXC_RETURN saved by PendSV_Handler along with r4-r11. A new task has
+	   not touched the FPU yet, so it starts with a basic stack frame. */
+	p_psp--;
+	*p_psp = EXC_RETURN_THREAD_PSP;
+#endif
+
+	p_psp -= 8;		/* space for r4-r11 */
+
+	return (uintptr_t)p_psp;
+} /* End of port_init_stack */
+
+#if TICKLESS_IDLE
+/* 
+ * port_idle()
+ * Brief	: Stops the periodic tick while only the idle task is runnable,
+ * 			  sleeps until the earliest wakeup, then reports the ticks that
+ * 			  were skipped
+ * Param	: @idle_ticks - Number of ticks until the earliest wakeup
+ * Retval	: Number of ticks to add to the tick count
+ * Note		: Called by the idle task with interrupts disabled. SysTick is a
+ * 			  24-bit counter, so a single sleep is limited to
+ * 			  MAX_IDLE_TICKS. Any other interrupt ends the sleep early; in that
+ * 			  case only the complete tick periods that elapsed are counted and
+ * 			  the counter is reloaded with the remainder of the current period,
+ * 			  so the tick phase is preserved.
+ */
+uint32_t port_idle(uint32_t idle_ticks)
+{
+	uint32_t reload;
+	uint32_t elapsed_cycles;
+	uint32_t elapsed_ticks;
+
+	/* Not worth reprogramming the timer; wait for the next regular tick */
+	if (idle_ticks < TICKLESS_MIN_IDLE_TICKS)
+	{
+		WAIT_FOR_INTERRUPT();
+		return 0;
+	}
+
+	/* Stop SysTick. (Write-only access so that COUNTFLAG is not cleared.) */
+	SYST_CSR = (TICKINT | CLKSOURCE);
+
+	/* The rest of the current tick period is still in SYST_CVR */
+	reload = SYST_CVR + ((idle_ticks - 1) * CYCLES_PER_TICK);
+
+	/* Start the one-shot sleep period */
+	SYST_RVR = reload;
+	SYST_CVR = 0;	/* Any write clears the counter so it reloads from SYST_RVR */
+	SYST_CSR = (TICKINT | CLKSOURCE | ENABLE);
+
+	WAIT_FOR_INTERRUPT();
+
+	/* Stop SysTick again and find out what woke the processor up */
+	SYST_CSR = (TICKINT | CLKSOURCE);
+
+	if (SYST_CSR & COUNTFLAG)	/* Reading clears COUNTFLAG */
+	{
+		/* The sleep period expired. Its last tick is pending and will be
+		   counted by SysTick_Handler() as usual. */
+		elapsed_ticks = idle_ticks - 1;
+
+		/* The counter reloaded and kept counting until it was stopped;
+		   shorten the next period by that amount to keep the tick phase. */
+		elapsed_cycles = reload - SYST_CVR;
+
+		if (elapsed_cycles >= CYCLES_PER_TICK)
+			elapsed_cycles = 0;
+
+		SYST_RVR = (CYCLES_PER_TICK - 1) - elapsed_cycles;
+	}
+	else
+	{
+		/* Woken up early by another interrupt. Count the complete tick
+		   periods and finish the current one before resuming normal ticks. */
+		elapsed_cycles = reload - SYST_CVR;
+		elapsed_ticks = elapsed_cycles / CYCLES_PER_TICK;
+
+		SYST_RVR = ((elapsed_ticks + 1) * CYCLES_PER_TICK) - elapsed_cycles - 1;
+	}
+
+	/* Restart SysTick from the adjusted reload value, then put the regular
+	   period back in place; it takes effect from the following reload. */
+	SYST_CVR = 0;
+	SYST_CSR = (TICKINT | CLKSOURCE | ENABLE);
+	SYST_RVR = CYCLES_PER_TICK - 1;
+
+	return elapsed_ticks;
+} /* End of port_idle */
+#endif /* TICKLESS_IDLE */
+
+/* 
+ * PendSV_Handler()
+ * Brief	: Performs context switching from curr_tcb to next_tcb
+ * Param	: None
+ * Retval	: None
+ * Note		: The next task has already been selected by schedule(), so this
+ * 			  handler makes no C calls: The save and restore are done inline
+ * 			  through the curr_tcb pointer (psp is at offset 0 of the TCB,
+ * 			  control at offset 4, stack_base at offset 8, mpu_regions at
+ * 			  offset 12).
+ * 			  If the next task turns out to be the current one (e.g., the
+ * 			  decision changed after the exception was pended), it returns
+ * 			  right away without touching r4-r11.
+ */
+__attribute__((naked)) void PendSV_Handler(void)
+{
+	/* SF1(r0-r3, r12, lr, pc, xpsr) of the current task are automatically 
+	   pushed onto its stack by the processor as exception ENTRY sequence. 
+	   (i.e., Stacking) */
+
+	/* CAUTION!
+	   You are in an EXCEPTION HANDLER, which uses MSP. When you use push/pop 
+	   operation in this handler, MSP will be affected! (This handler uses
+	   neither.) */
+
+	/* 1. r2 = &curr_tcb, r0 = curr_tcb, r1 = next_tcb */
+	__asm volatile("movw r2, #:lower16:curr_tcb");
+	__asm volatile("movt r2, #:upper16:curr_tcb");
+	__asm volatile("ldr r0, [r2]");
+	__asm volatile("movw r3, #:lower16:next_tcb");
+	__asm volatile("movt r3, #:upper16:next_tcb");
+	__asm volatile("ldr r1, [r3]");
+		/* Loading next_tcb is a single word access, so it needs no masking.
+		   An ISR that changes it afterwards pends PendSV again. */
+
+	/* 2. Same task: Nothing to switch (Fast exit) */
+	__asm volatile("cmp r0, r1");
+	__asm volatile("it eq\n\t"
+				   "bxeq lr");
+
+	/***************************************************************************
+	 * PART1: Task switching out (Save the context of the current task)
+	 **************************************************************************/
+
+	/* 3. Get the current task's PSP */
+	__asm volatile("mrs r3, psp");
+
+#if FPU_ENABLED
+	/* 4. If the task has used the FPU (EXC_RETURN bit[4] == 0), the processor
+	   has reserved an extended frame for s0-s15/FPSCR (filled lazily thanks to
+	   LSPEN); save the callee-saved s16-s31 on top of it. Integer-only tasks
+	   skip this and keep the cheap switch. */
+	__asm volatile("tst lr, #0x10");
+	__asm volatile("it eq\n\t"
+				   "vstmdbeq r3!, {s16-s31}");
+
+	/* 5. Save SF2(r4-r11) and EXC_RETURN of the current task; the latter tells
+	   which frame type to restore when the task is switched back in */
+	__asm volatile("stmdb r3!, {r4-r11, lr}");
+#else
+	/* 4. Save SF2(r4-r11) of the current task by using its PSP */
+	__asm volatile("stmdb r3!, {r4-r11}"); 	/* Register to memory */
+		/* STMDB: STore Multiple registers. Decrement address Before each access.
+		   !	: An optional writeback suffix. If ! is present the final address,
+				  that is loaded from or stored to, is written back into the base
+				  register. In this case, r3. */
+#endif
+
+	/* 6. Save the updated PSP of the current task (curr_tcb->psp) */
+	__asm volatile("str r3, [r0]");
+
+#if STACK_CHECK && !MPU_ENABLED
+	/* 7. Stack check of the current task (r0 = curr_tcb): The context just
+	   saved must lie within its stack (curr_tcb->stack_base), and the lowest
+	   word must still hold STACK_PAINT. Either failure means the stack has
+	   overflowed into whatever lies below it. (Wide branches: The handler
+	   may be linked anywhere in FLASH.) */
+	__asm volatile("ldr r12, [r0, #8]");
+	__asm volatile("cmp r3, r12");
+	__asm volatile("blo.w stack_overflow_handler");
+	__asm volatile("ldr r12, [r12]");
+	__asm volatile("cmp r12, #0xA5A5A5A5");		/* STACK_PAINT */
+	__asm volatile("bne.w stack_overflow_handler");
+#endif
+
+	/***************************************************************************
+	 * PART2: Task switching in (Restore the context of the next task)
+	 **************************************************************************/
+
+	/* 1. curr_tcb = next_tcb */
+	__asm volatile("str r1, [r2]");
+
+#if MPU_ENABLED
+	/* 1a. Give the MPU the stack and stack guard regions of the next task
+	   (next_tcb->mpu_regions): Two RBAR/RASR pairs, written through RBAR/RASR
+	   and their first alias with one STM. r4-r7 are free until the restore
+	   below. The exception return orders it before the task's first access. */
+	__asm volatile("add r3, r1, #12");
+	__asm volatile("ldmia r3, {r4-r7}");
+	__asm volatile("movw r3, #0xED9C");			/* MPU_RBAR */
+	__asm volatile("movt r3, #0xE000");
+	__asm volatile("stmia r3, {r4-r7}");
+#endif
+
+	/* 2. Get the next task's PSP (next_tcb->psp) */
+	__asm volatile("ldr r3, [r1]");
+
+#if FPU_ENABLED
+	/* 3. Restore SF2(r4-r11) and EXC_RETURN of the next task, then its s16-s31
+	   if it is an FPU user */
+	__asm volatile("ldmia r3!, {r4-r11, lr}");
+	__asm volatile("tst lr, #0x10");
+	__asm volatile("it eq\n\t"
+				   "vldmiaeq r3!, {s16-s31}");
+#else
+	/* 3. Restore SF2(r4-r11) of the next task by using its PSP */
+	__asm volatile("ldmia r3!, {r4-r11}");	/* Memory to register */
+		/* LDMIA: LoaD Multiple registers. Increment address After each access.
+		   !	: An optional writeback suffix. If ! is present the final 
+		   		  address, that is loaded from or stored to, is written back 
+				  into the base register. In this case, r3. */
+#endif
+
+	/* 4. Update PSP */
+	__asm volatile("msr psp, r3");	/* Now PSP points to the stack of the task switched in */
+
+	/* 5. Privilege level of the next task (next_tcb->control); in Handler
+	   mode, only nPRIV (and FPCA, which the return sets again) is written */
+	__asm volatile("ldr r0, [r1, #4]");
+	__asm volatile("msr control, r0");
+
+	__asm volatile("bx lr");
+
+	/* SF1(r0-r3, r12, lr, pc, xpsr) of the current task are automatically 
+	   popped out of its stack and restored by the processor as exception EXIT 
+	   sequence. (i.e., Unstacking) */
+} /* End of PendSV_Handler */
+
+/*
+ * svc_access_fault()
+ * Brief	: Stops the system on a system call with an argument the caller
+ * 			  may not pass
+ * Param	: @num - System call number
+ * 			: @args - Arguments in r0-r3 of the caller
+ * Retval	: None (Does not return)
+ * Note		: The kernel would have accessed memory the task can't, so this
+ * 			  is handled like the MemManage fault the access would have
+ * 			  raised in the task itself.
+ */
+void svc_access_fault(uint32_t num, const uint32_t *args)
+{
+	printf("Exception: MemManage (System call %lu, args 0x%08lx 0x%08lx 0x%08lx 0x%08lx, task %p)\n",
+		   (unsigned long)num, (unsigned long)args[0], (unsigned long)args[1],
+		   (unsigned long)args[2], (unsigned long)args[3], (void *)curr_tcb);
+	while (1);
+} /* End of svc_access_fault */
+
+/*
+ * port_access_ok()
+ * Brief	: Tells whether the running task may access a memory range itself
+ * Param	: @addr - Start of the range
+ * 			: @size - Size of the range in bytes
+ * Retval	: 1 if the range lies within the task's stack (Above the guard) or
+ * 			  within SRAM, 0 otherwise
+ * Note		: The regions the MPU grants an unprivileged task for data; CCM RAM
+ * 			  (Kernel data, the other task stacks) is never in them.
+ */
+uint32_t port_access_ok(uintptr_t addr, uint32_t size)
+{
+	uintptr_t stack_start = curr_tcb->stack_base + STACK_GUARD_SIZE;
+	uintptr_t stack_end = curr_tcb->stack_base + curr_tcb->stack_size;
+
+	if (addr > (UINTPTR_MAX - size))
+		return 0;
+
+	if ((addr >= stack_start) && ((addr + size) <= stack_end))
+		return 1;
+
+	return ((addr >= SRAM_START) && ((addr + size) <= SRAM_END));
+} /* End of port_access_ok */
+
+/*
+ * svc_trampoline()
+ * Brief	: Runs a kernel service on behalf of a task, then leaves the system
+ * 			  call
+ * Param	: None (r0-r3: Arguments, r12: Service)
+ * Retval	: None (r0: Return value of the service)
+ * Note		: Reached from svc_dispatch() only, in privileged Thread mode.
+ * 			  The stack pointer is the caller's at its SVC, where a fifth
+ * 			  argument was stored.
+ */
+__attribute__((naked)) void svc_trampoline(void)
+{
+	__asm volatile("blx r12");
+	__asm volatile("mov r12, #0xFF");	/* SYS_RETURN */
+	__asm volatile("svc 0");
+} /* End of svc_trampoline */
+
+/*
+ * svc_dispatch()
+ * Brief	: Enters or leaves a system call
+ * Param	: @frame - Exception frame of the calling task (r0-r3, r12, lr, pc,
+ * 					   xpsr)
+ * Retval	: None
+ * Note		: Entering redirects the exception return to svc_trampoline() in
+ * 			  privileged Thread mode, with the service in r12 and the caller's
+ * 			  arguments left in r0-r3. Leaving (SYS_RETURN) drops the
+ * 			  privilege and returns to the instruction after the caller's SVC,
+ * 			  with the service's return value in r0. PendSV may switch tasks
+ * 			  in between; it restores each task's CONTROL from its TCB.
+ * 			  Entering checks the pointer arguments first (svc_args_ok()).
+ */
+void svc_dispatch(uint32_t *frame)
+{
+	uint32_t num = frame[4];
+
+	if (num == SYS_RETURN)
+	{
+		frame[6] = curr_tcb->svc_return;
+		curr_tcb->control = TASK_CONTROL;
+	}
+	else if ((num < NUM_SYSCALLS) && (svc_table[num] != NULL))
+	{
+		/* Pointers the service would use with the kernel's privilege */
+		if (!svc_args_ok(num, frame))
+			svc_access_fault(num, frame);
+
+		curr_tcb->svc_return = frame[6];
+		frame[4] = (uint32_t)svc_table[num];
+		frame[6] = (uint32_t)svc_trampoline & ~1U;	/* Stacked PC has no Thumb bit */
+		curr_tcb->control = 0U;
+	}
+	else
+	{
+		frame[0] = (uint32_t)E_INVALID;
+		return;
+	}
+
+	__asm volatile("msr control, %0" : : "r" (curr_tcb->control) : "memory");
+} /* End of svc_dispatch */
+
+/*
+ * svc_start_first_task()
+ * Brief	: Switches from main() to curr_tcb
+ * Param	: None (r0: Top of the scheduler stack)
+ * Retval	: None
+ * Note		: Reached from SVC_Handler() only, for the SVC of
+ * 			  port_start_first_task(). Restores the initial context of the
+ * 			  first task the way PART2 of PendSV_Handler() does, and moves MSP
+ * 			  to the scheduler stack: main()'s stack, and the SVC frame on it,
+ * 			  are never returned to.
+ */
+__attribute__((naked)) void svc_start_first_task(void)
+{
+	/* 1. Exceptions use the scheduler stack from now on */
+	__asm volatile("msr msp, r0");
+
+	/* 2. r1 = curr_tcb */
+	__asm volatile("movw r1, #:lower16:curr_tcb");
+	__asm volatile("movt r1, #:upper16:curr_tcb");
+	__asm volatile("ldr r1, [r1]");
+
+	/* 3. Restore SF2(r4-r11) from the initial context (curr_tcb->psp) */
+	__asm volatile("ldr r3, [r1]");
+#if FPU_ENABLED
+	__asm volatile("ldmia r3!, {r4-r11, lr}");	/* Saved EXC_RETURN: Basic frame */
+#else
+	__asm volatile("ldmia r3!, {r4-r11}");
+	__asm volatile("mvn lr, #2");				/* EXC_RETURN_THREAD_PSP */
+#endif
+	__asm volatile("msr psp, r3");
+
+	/* 4. Privilege level of the first task (curr_tcb->control) */
+	__asm volatile("ldr r0, [r1, #4]");
+	__asm volatile("msr control, r0");
+
+	/* 5. Unmask SysTick and PendSV (port_start_first_task()) */
+	__asm volatile("mov r0, #0");
+	__asm volatile("msr basepri, r0");
+
+	__asm volatile("bx lr");	/* Unstacks r0 (arg) and pc (task_handler) */
+} /* End of svc_start_first_task */
+
+/*
+ * SVC_Handler()
+ * Brief	: System call entry (SVC instruction)
+ * Param	: None
+ * Retval	: None
+ * Note		: Tasks issue SVC on PSP; the one SVC on MSP is main()'s, which
+ * 			  starts the first task (EXC_RETURN bit[2] tells them apart). SVC
+ * 			  keeps its reset priority (0), above KERNEL_INTERRUPT_PRIORITY, so
+ * 			  that a system call is never masked by a critical section.
+ */
+__attribute__((naked)) void SVC_Handler(void)
+{
+	__asm volatile("tst lr, #0x04");
+	__asm volatile("beq.w svc_start_first_task");
+	__asm volatile("mrs r0, psp");
+	__asm volatile("b svc_dispatch");	/* Returns straight to the task */
+} /* End of SVC_Handler */
+
+/* 
+ * SysTick_Handler()
+ * Brief	: Tick interrupt; runs the kernel's tick processing
+ * Param	: None
+ * Retval	: None
+ * Note		: N/A
+ */
+void SysTick_Handler(void)
+{
+	kernel_tick();
+} /* End of SysTick_Handler */
+
+/* 
+ * enable_processor_faults()
+ * Brief	: Enable all configurable exceptions (i.e., UsageFault, MemManage, 
+ * 			  BusFault) 
+ * Param	: None
+ * Retval	: None
+ * Note		: N/A
+ */
+void enable_processor_faults(void)
+{
+	SHCSR |= USGFAULTENA;	/* Enable UsageFault */
+	SHCSR |= BUSFAULTENA;	/* Enable BusFault */
+	SHCSR |= MEMFAULTENA;	/* Enable MemManage */
+
+	/* Since the kernel performs various memory access enabling these faults will help us
+	 * track down the issues.
+	 */
+} /* End of enable_processor_faults */
+
+/* 
+ * HardFault_Handler()
+ * Brief	: HardFault handler 
+ * Param	: None
+ * Retval	: None
+ * Note		: N/A
+ */
+void HardFault_Handler(void)
+{
+	printf("Exception: HardFault\n");
+	while (1);
+} /* End of HardFault_Handler() */
+
+/* 
+ * MemManage_Handler()
+ * Brief	: MemManage handler 
+ * Param	: None
+ * Retval	: None
+ * Note		: With the MPU on, this is where a task lands that overflows its
+ * 			  stack into the guard (MMFAR: Address in the guard) or touches
+ * 			  memory outside its regions.
+ */
+void MemManage_Handler(void)
+{
+	uint8_t mmfsr = MMFSR;
+
+	if (mmfsr & MMARVALID)
+		printf("Exception: MemManage (MMFSR 0x%02x, address 0x%08lx, task %p)\n",
+			   mmfsr, (unsigned long)MMFAR, (void *)curr_tcb);
+	else
+		printf("Exception: MemManage (MMFSR 0x%02x, task %p)\n", mmfsr, (void *)curr_tcb);
+	while (1);
+} /* End of MemManage_Handler() */
+
+#if STACK_CHECK && !MPU_ENABLED
+/*
+ * stack_overflow_handler()
+ * Brief	: Stops the system on a task stack overflow
+ * Param	: @tcb - Task whose stack overflowed (r0 of PendSV_Handler())
+ * Retval	: None (Does not return)
+ * Note		: Branched to by PendSV_Handler() while switching the task out,
+ * 			  i.e. before the task (or the one whose memory it overwrote) can
+ * 			  run again.
+ */
+void stack_overflow_handler(TCB_t *tcb)
+{
+	printf("Exception: Stack overflow (Task %p, stack %p, %lu bytes)\n", (void *)tcb,
+		   (void *)tcb->stack_base, (unsigned long)tcb->stack_size);
+	while (1);
+} /* End of stack_overflow_handler */
+#endif
+
+/* 
+ * BusFault_Handler()
+ * Brief	: BusFault handler 
+ * Param	: None
+ * Retval	: None
+ * Note		: N/A
+ */
+void BusFault_Handler(void)
+{
+
+	printf("Exception: BusFault\n");
+	while (1);
+} /* End of BusFault_Handler() */
+
+#if MPU_ENABLED
+/*
+ * mpu_init()
+ * Brief	: Programs the regions shared by all tasks and enables the MPU
+ * Param	: None
+ * Retval	: None
+ * Note		: Privileged code keeps the default memory map wherever no region
+ * 			  applies (PRIVDEFENA), e.g., for the TCBs and the other task
+ * 			  stacks in CCM RAM; unprivileged tasks only get these regions and
+ * 			  their own stack. Regions 3-5 are left free for the application.
+ */
+void mpu_init(void)
+{
+	/* FLASH (1 MiB): Code and constants; read-only, executable */
+	MPU_RBAR = 0x08000000U | MPU_RBAR_VALID | MPU_REGION_FLASH;
+	MPU_RASR = MPU_RASR_AP_RO | MPU_RASR_C | MPU_RASR_SIZE(20U) | MPU_RASR_ENABLE;
+
+	/* SRAM (128 KiB): Data, heap, memory pools, main() stack; never executed */
+	MPU_RBAR = SRAM_START | MPU_RBAR_VALID | MPU_REGION_SRAM;
+	MPU_RASR = MPU_RASR_XN | MPU_RASR_AP_RW | MPU_RASR_S | MPU_RASR_C | MPU_RASR_SIZE(17U) |
+			   MPU_RASR_ENABLE;
+
+	/* Peripherals (512 MiB, APB/AHB): Device memory, never executed */
+	MPU_RBAR = 0x40000000U | MPU_RBAR_VALID | MPU_REGION_PERIPH;
+	MPU_RASR = MPU_RASR_XN | MPU_RASR_AP_RW | MPU_RASR_S | MPU_RASR_B | MPU_RASR_SIZE(29U) |
+			   MPU_RASR_ENABLE;
+
+	MPU_CTRL = PRIVDEFENA | MPU_CTRL_ENABLE;
+	__asm volatile("dsb");
+	__asm volatile("isb");
+} /* End of mpu_init */
+
+/*
+ * port_mpu_stack_regions()
+ * Brief	: Computes the MPU regions of a task stack
+ * Param	: @stack_base - Lowest address of the task stack (Aligned to its size)
+ * 			: @stack_size - Stack size in bytes (Power of two, >= MIN_STACK_SIZE)
+ * 			: @regions - Where to store the RBAR/RASR pairs of the stack and of
+ * 						 its guard (TCB mpu_regions)
+ * Retval	: None
+ * Note		: The guard is the lowest STACK_GUARD_SIZE bytes of the stack
+ * 			  itself, made inaccessible even to privileged code by the
+ * 			  higher-numbered region. Keeping it inside the stack means no
+ * 			  memory is lost between stacks, and no other task's memory is
+ * 			  ever covered by it.
+ */
+void port_mpu_stack_regions(uintptr_t stack_base, uint32_t stack_size, uint32_t *regions)
+{
+	uint32_t size_log2 = 31U - __builtin_clz(stack_size);
+
+	regions[0] = stack_base | MPU_RBAR_VALID | MPU_REGION_STACK;
+	regions[1] = MPU_RASR_XN | MPU_RASR_AP_RW | MPU_RASR_S | MPU_RASR_C |
+				 MPU_RASR_SIZE(size_log2) | MPU_RASR_ENABLE;
+	regions[2] = stack_base | MPU_RBAR_VALID | MPU_REGION_GUARD;
+	regions[3] = MPU_RASR_XN | MPU_RASR_AP_NONE | MPU_RASR_SIZE(5U) | MPU_RASR_ENABLE;
+		/* 5: STACK_GUARD_SIZE = 32 bytes */
+} /* End of port_mpu_stack_regions */
+#endif /* MPU_ENABLED */
+
+/* 
+ * port_init()
+ * Brief	: Does the processor specific initializations
+ * Param	: None
+ * Retval	: None
+ * Note		: N/A
+ */
+void port_init(void)
+{
+	enable_processor_faults();
+
+#if MPU_ENABLED
+	mpu_init();
+#endif
+
+#if FPU_ENABLED
+	/* Automatic FP state preservation with lazy stacking: The processor only
+	   reserves space for s0-s15/FPSCR on exception entry and saves them if the
+	   handler itself executes an FP instruction. (Reset value; made explicit
+	   since PendSV_Handler relies on it.) */
+	FPCCR |= (ASPEN | LSPEN);
+#endif
+
+#if KERNEL_STATS && !CYCLE_COUNT_SYSTICK
+	/* Start the DWT cycle counter used to time kernel paths */
+	DEMCR |= TRCENA;
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= CYCCNTENA;
+#endif
+
+	/* PendSV must be the lowest priority exception so that it only switches
+	   tasks once every other ISR has made its scheduling decision. SysTick
+	   goes along with it, below KERNEL_INTERRUPT_PRIORITY, so that critical
+	   sections (BASEPRI) mask it. */
+	SHPR3 |= (PENDSV_PRIORITY_LOWEST | SYSTICK_PRIORITY_LOWEST);
+	SET_BASEPRI(0U);
+} /* End of port_init */
+
+/* 
+ * port_start_first_task()
+ * Brief	: Starts SysTick and leaves main() for curr_tcb through SVC
+ * Param	: None
+ * Retval	: None (Does not return)
+ * Note		: The first task is entered by an exception return from its
+ * 			  initial context (svc_start_first_task()), like any task that
+ * 			  PendSV_Handler() switches in, so it gets its privilege level and
+ * 			  its stack together. Thread mode never runs unprivileged on
+ * 			  main()'s stack, where curr_tcb would be out of its reach.
+ * 			  SysTick and PendSV stay masked until then.
+ */
+void port_start_first_task(void)
+{
+	SET_BASEPRI(KERNEL_INTERRUPT_PRIORITY);
+
+	init_systick_timer(TICK_HZ);
+
+#if MPU_ENABLED
+	/* Stack regions of the first task; PendSV_Handler() takes over from here */
+	for (uint32_t i = 0; i < 4U; i++)
+		(&MPU_RBAR)[i] = curr_tcb->mpu_regions[i];
+	__asm volatile("dsb");
+	__asm volatile("isb");
+#endif
+
+	/* SVC is not masked by BASEPRI; the scheduler stack top goes in r0 */
+	register uint32_t sched_top __asm ("r0") = (uint32_t)sched_stack + SIZE_SCHED_STACK;
+	__asm volatile("svc 0" : : "r" (sched_top) : "memory");
+
+	while (1);	/* Not reached */
+} /* End of port_start_first_task */
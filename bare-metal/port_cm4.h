@@ -0,0 +1,369 @@
+/*******************************************************************************
+ * File		: port_cm4.h
+ * Brief	: ARM Cortex-M4 (STM32F407) port definitions
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef PORT_CM4_H
+#define PORT_CM4_H
+
+/* Memory protection: The MPU confines every task to its own stack plus the
+   shared FLASH, SRAM and peripheral regions, and the lowest STACK_GUARD_SIZE
+   bytes of each stack are a no-access guard, so a stack overflow or a stray
+   write traps (MemManage) at the faulting instruction. PendSV_Handler()
+   reloads the two per-task regions on every switch. Build with
+   -DMPU_ENABLED=0 to leave the MPU off (Stack overflows are then only caught
+   by the STACK_CHECK test in PendSV_Handler()). */
+#ifndef MPU_ENABLED
+#define MPU_ENABLED			1U
+#endif
+
+/* Stack memory information */
+#if MPU_ENABLED
+#define MIN_STACK_SIZE		256U	/* Guard + initial context + exception frame + margin */
+#else
+#define MIN_STACK_SIZE		128U	/* Initial context + exception frame + margin */
+#endif
+#define SIZE_SCHED_STACK	1024U
+#define SRAM_START			0x20000000U
+#define SIZE_SRAM			((128) * (1024))
+#define SRAM_END			((SRAM_START) + (SIZE_SRAM))
+	/* main() runs on the stack below SRAM_END until start_kernel():
+	   _main_stack_size bytes, which stm32_ls.ld keeps the rest of SRAM clear
+	   of */
+#define CCMRAM_START		0x10000000U
+#define SIZE_CCMRAM			((64) * (1024))
+
+/* System timer registers */
+/* SysTick Reload Value Register (Stores 24-bit down counter START value) */
+#define SYST_RVR			(*(uint32_t volatile *)0xE000E014)
+/* SysTick Current Value Register (Any write clears it to 0) */
+#define SYST_CVR			(*(uint32_t volatile *)0xE000E018)
+/* SysTick Control and Status Register */
+#define SYST_CSR			(*(uint32_t volatile *)0xE000E010)
+#define ENABLE				(1 << 0U) /* Counter enabled */
+#define TICKINT				(1 << 1U) /* Counting down to zero asserts the SysTick exception request */
+#define CLKSOURCE			(1 << 2U) /* Processor clock */
+#define COUNTFLAG			(1 << 16U) /* Counter reached 0 since last read (Cleared on read) */
+
+/* PendSV */
+/* Interrupt Control and State Register (ICSR) */
+#define ICSR				(*(uint32_t volatile *)0xE000ED04)
+#define PENDSVSET			(1 << 28U)	/* Change PendSV exception state to pending */
+
+/* System Handler Priority Register 3 (PendSV: bits[23:16], SysTick: bits[31:24]) */
+#define SHPR3				(*(uint32_t volatile *)0xE000ED20)
+#define PENDSV_PRIORITY_LOWEST	(0xFFU << 16U)
+#define SYSTICK_PRIORITY_LOWEST	(0xFFU << 24U)
+
+/* Highest priority of the interrupts that may call into the kernel (STM32F4:
+   4 priority bits, in bits[7:4]). Critical sections raise BASEPRI to it, so
+   interrupts with a numerically lower (higher) priority are never delayed by
+   the kernel, but must not use it. Must be non-zero. */
+#ifndef KERNEL_INTERRUPT_PRIORITY
+#define KERNEL_INTERRUPT_PRIORITY	(5U << 4U)
+#endif
+
+/* Depth of the current critical section (0: Not in one) */
+extern volatile uint32_t critical_nesting;
+
+/* Write BASEPRI; the ISB makes the new mask effective before the next
+   instruction, and the clobber keeps memory accesses on their side of it */
+#define SET_BASEPRI(x)		do { __asm volatile ("msr basepri, %0\n\tisb" : : "r" (x) : "memory"); } while (0)
+
+/* Enter a critical section: Mask the interrupts at KERNEL_INTERRUPT_PRIORITY
+   and below (SysTick, PendSV, kernel aware ISRs) */
+#define ENTER_CRITICAL()	do { SET_BASEPRI(KERNEL_INTERRUPT_PRIORITY); critical_nesting++; } while (0)
+
+/* Exit a critical section: Only the outermost exit unmasks, at which point a
+   context switch pended inside takes place */
+#define EXIT_CRITICAL()		do { if (--critical_nesting == 0U) SET_BASEPRI(0U); } while (0)
+
+/* Disable interrupts */
+#define DISABLE_INTERRUPTS()	do { __asm volatile ("CPSID i" : : : "memory"); } while (0)
+	/* To disable interrupts for ARM Cortex-M4 processor, you can use the
+	   "CPSID i" assembly instruction. This instruction sets the "PRIMASK"
+	   register to disable all interrupts, including the non-maskable
+	   interrupt (NMI). */
+	/* The do-while loop construct ensures that the macro expands to a single
+	   statement, even if it is used in a context where multiple statements are
+	   expected (e.g., as the body of an if statement). The while (0) part of
+	   the loop is there to ensure that the macro can be used safely in compound
+	   statements without generating syntax errors. */
+	/* Another way of writing DISABLE_INTERRUPTS() is as follows:
+	   do { __asm volatile ("mov r0, #0x1"); asm volatile ("mrs primask, r0"); } while (0)
+	   In this case, using do-while statement helps ensuring that the compound
+	   statements in the body expand to a single statement, as we put parens
+	   around every single macro variables. */
+
+/* Enable interrupts */
+#define ENABLE_INTERRUPTS() 	do { __asm volatile ("CPSIE i" : : : "memory"); } while (0)
+	/* Another way of writing DISABLE_INTERRUPTS() is as follows:
+	   do { __asm volatile ("mov r0, #0x0"); asm volatile ("mrs primask, r0"); } while (0)  */
+
+/* Data Memory Barrier: Memory accesses before it are observed before the ones
+   after it (Also keeps the compiler from reordering them) */
+#define MEMORY_BARRIER()		do { __asm volatile ("dmb" : : : "memory"); } while (0)
+
+/* Sleep until an interrupt is pending (Wakes up even when PRIMASK is set) */
+#define WAIT_FOR_INTERRUPT()	do { __asm volatile ("dsb"); __asm volatile ("wfi"); __asm volatile ("isb"); } while (0)
+
+/* Context switch: PendSV_Handler() switches from curr_tcb to next_tcb */
+#define PEND_CONTEXT_SWITCH()	do { ICSR |= PENDSVSET; } while (0)
+
+/* Unprivileged tasks: Build with -DUNPRIVILEGED_TASKS=0 to run every task
+   privileged (e.g., bench.c, which reads SysTick directly). The idle task is
+   always privileged. */
+#ifndef UNPRIVILEGED_TASKS
+#define UNPRIVILEGED_TASKS	1U
+#endif
+
+/* CONTROL register */
+#define CONTROL_NPRIV		(1U << 0U)	/* Thread mode is unprivileged */
+#define CONTROL_SPSEL		(1U << 1U)	/* Thread mode uses PSP */
+
+#if UNPRIVILEGED_TASKS
+#define TASK_CONTROL		CONTROL_NPRIV
+#else
+#define TASK_CONTROL		0U
+#endif
+
+/* System calls: The number goes in r12 and the arguments in r0-r3 (The fifth
+   one, if any, on the stack), where the SVC exception frame keeps them for
+   SVC_Handler() and the service. See port_syscall(). */
+#if UNPRIVILEGED_TASKS
+#define IS_PRIVILEGED()		port_is_privileged()
+#else
+#define IS_PRIVILEGED()		1U
+#endif
+#define SYSCALL(num, a0, a1, a2, a3) \
+	port_syscall((num), (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3))
+#define SYSCALL5(num, a0, a1, a2, a3, a4) \
+	port_syscall5((num), (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3), \
+				  (uint32_t)(a4))
+
+/* Places a variable in an output section of stm32_ls.ld */
+#define SECTION(name)		__attribute__((section(name)))
+
+/* The TCBs, the task stack pool, the scheduler (MSP) stack and the rest of the
+   kernel state live in the core-coupled memory: Zero wait state, and never
+   stalled by a DMA transfer (DMA can't reach CCM at all), which leaves the
+   main SRAM to DMA buffers. No MPU region gives unprivileged tasks CCM, so
+   they can't access the kernel state directly (Which is not isolation from
+   a hostile task; see svc.h). Build with -DKERNEL_IN_CCM=0 to
+   put them back in SRAM (.bss), e.g., to compare the timings; the SRAM region
+   would then hand the kernel data to every task, so this needs
+   -DUNPRIVILEGED_TASKS=0 while the MPU is on (As bench.c is built). Buffers
+   on a task stack can't be used for DMA. */
+#ifndef KERNEL_IN_CCM
+#define KERNEL_IN_CCM		1U
+#endif
+
+#if KERNEL_IN_CCM
+#define KERNEL_DATA			SECTION(".ccmram")
+#else
+#define KERNEL_DATA
+#endif
+
+#if MPU_ENABLED && UNPRIVILEGED_TASKS && !KERNEL_IN_CCM
+#error "KERNEL_IN_CCM=0 leaves the kernel data in the tasks' SRAM region: Build with UNPRIVILEGED_TASKS=0 or MPU_ENABLED=0"
+#endif
+
+/* An MPU region must be a power of two in size (32 bytes at least) and start
+   at a multiple of its size, so with the MPU on, task stacks are rounded up
+   to a power of two and aligned to their size in the stack pool */
+#if MPU_ENABLED
+#define STACK_GUARD_SIZE	32U		/* Smallest MPU region */
+#define STACK_SIZE_ROUND(size)	(1U << (32U - __builtin_clz((size) - 1U)))
+#define STACK_ALIGN(size)	(size)
+#else
+#define STACK_GUARD_SIZE	0U
+#define STACK_SIZE_ROUND(size)	(((size) + 7U) & ~7U)
+#define STACK_ALIGN(size)	8U
+#endif
+
+/* Memory Protection Unit (MPU) registers */
+/* MPU Control Register */
+#define MPU_CTRL			(*(uint32_t volatile *)0xE000ED94)
+#define MPU_CTRL_ENABLE		(1U << 0U)
+#define PRIVDEFENA			(1U << 2U)	/* Default memory map for privileged accesses outside the regions */
+/* MPU Region Base Address Register; RBAR and RASR repeat at the next three
+   word pairs (Aliases), so 4 regions can be written with one STM */
+#define MPU_RBAR			(*(uint32_t volatile *)0xE000ED9C)
+#define MPU_RBAR_VALID		(1U << 4U)	/* Region number in bits[3:0] selects the region */
+/* MPU Region Attribute and Size Register */
+#define MPU_RASR			(*(uint32_t volatile *)0xE000EDA0)
+#define MPU_RASR_ENABLE		(1U << 0U)
+#define MPU_RASR_SIZE(log2)	(((log2) - 1U) << 1U)	/* Region of (1 << log2) bytes */
+#define MPU_RASR_B			(1U << 16U)	/* Bufferable */
+#define MPU_RASR_C			(1U << 17U)	/* Cacheable */
+#define MPU_RASR_S			(1U << 18U)	/* Shareable */
+#define MPU_RASR_AP_NONE	(0U << 24U)	/* No access */
+#define MPU_RASR_AP_RW		(3U << 24U)	/* Full access */
+#define MPU_RASR_AP_RO		(6U << 24U)	/* Read-only, privileged or not */
+#define MPU_RASR_XN			(1U << 28U)	/* Execute never */
+/* MemManage Fault Status Register (MMFSR) - 8-bit register */
+#define MMFSR				(*(uint8_t volatile *)0xE000ED28)
+#define MMARVALID			(1U << 7U)	/* MMFAR holds the faulting address */
+/* MemManage Fault Address Register */
+#define MMFAR				(*(uint32_t volatile *)0xE000ED34)
+
+/* MPU regions (A higher number wins where regions overlap) */
+#define MPU_REGION_FLASH	0U
+#define MPU_REGION_SRAM		1U
+#define MPU_REGION_PERIPH	2U
+#define MPU_REGION_STACK	6U		/* Stack of the running task */
+#define MPU_REGION_GUARD	7U		/* Bottom of the stack of the running task */
+
+/* Clock */
+#define HSI_CLK				16000000U
+#define SYSTICK_TIM_CLK		HSI_CLK		/* By default */
+#define CYCLES_PER_TICK		((SYSTICK_TIM_CLK) / (TICK_HZ))
+
+/* Tickless idle: SysTick is a 24-bit counter */
+#define MAX_IDLE_TICKS		((0x00FFFFFFU / (CYCLES_PER_TICK)) - 1U)
+
+#define DUMMY_XPSR			0x01000000U	/* Guarantee T-bit is set */
+
+/* System Handler Control and State Register (SHCRS); one of the System Control Block registers */
+#define	SHCSR				(*(uint32_t volatile *)0xE000ED24)
+#define USGFAULTENA			(1 << 18U)
+#define BUSFAULTENA			(1 << 17U)
+#define MEMFAULTENA			(1 << 16U)
+/* UsageFault Status Register (UFSR) - 16-bit register */
+#define UFSR				(*(uint32_t volatile *)0xE000ED2A)
+/* Configuration and Control Register */
+#define CCR					(*(uint32_t volatile *)0xE000ED14)
+#define DIV_0_TRP			(1 << 4U)
+
+/* Data Watchpoint and Trace (DWT) unit; used for cycle-accurate measurements */
+/* Debug Exception and Monitor Control Register */
+#define DEMCR				(*(uint32_t volatile *)0xE000EDFC)
+#define TRCENA				(1 << 24U)	/* Enable DWT */
+/* DWT Control Register */
+#define DWT_CTRL			(*(uint32_t volatile *)0xE0001000)
+#define CYCCNTENA			(1 << 0U)	/* Enable cycle counter */
+/* DWT Cycle Count Register */
+#define DWT_CYCCNT			(*(uint32_t volatile *)0xE0001004)
+
+/* Cycle counter used by KERNEL_STATS. Build with -DCYCLE_COUNT_SYSTICK=1 on
+   targets without a DWT (e.g., QEMU): Cycles are then counted since the last
+   SysTick reload, which is only valid for intervals shorter than one tick. */
+#ifndef CYCLE_COUNT_SYSTICK
+#define CYCLE_COUNT_SYSTICK	0U
+#endif
+
+/* Processor cycles since the last SysTick reload (Counter runs down from RVR) */
+#define SYSTICK_ELAPSED()	((SYST_RVR & 0x00FFFFFFU) - SYST_CVR)
+
+#if CYCLE_COUNT_SYSTICK
+#define CYCLE_COUNT()		SYSTICK_ELAPSED()
+#else
+#define CYCLE_COUNT()		(DWT_CYCCNT)
+#endif
+
+/* Floating-Point Unit */
+#if defined(__ARM_FP)
+#define FPU_ENABLED			1U	/* Built with -mfloat-abi=hard (or softfp) */
+#else
+#define FPU_ENABLED			0U	/* Built with -mfloat-abi=soft */
+#endif
+/* Floating-Point Context Control Register */
+#define FPCCR				(*(uint32_t volatile *)0xE000EF34)
+#define ASPEN				(1U << 31U)	/* Set CONTROL.FPCA on FP instruction execution */
+#define LSPEN				(1U << 30U)	/* Lazy state preservation of s0-s15/FPSCR */
+
+/* EXC_RETURN: Return to Thread mode using PSP, basic (non-FP) stack frame */
+#define EXC_RETURN_THREAD_PSP	0xFFFFFFFDU
+
+/*
+ * port_is_privileged()
+ * Brief	: Tells whether the caller may use the kernel directly
+ * Param	: None
+ * Retval	: Non-zero in Handler mode or in privileged Thread mode
+ * Note		: N/A
+ */
+static inline uint32_t port_is_privileged(void)
+{
+	uint32_t reg;
+
+	__asm volatile ("mrs %0, ipsr" : "=r" (reg));
+	if (reg != 0U)
+		return 1U;
+
+	__asm volatile ("mrs %0, control" : "=r" (reg));
+
+	return ((reg & CONTROL_NPRIV) == 0U);
+} /* End of port_is_privileged */
+
+/* Registers a system call clobbers besides r0-r3 and r12: The service runs in
+   Thread mode as a plain function call, so with the FPU it may also leave the
+   caller-saved s0-s15 changed. (It never changes the FPSCR rounding and
+   exception control bits, which the AAPCS has callees preserve.) */
+#if defined(__ARM_FP)
+#define SYSCALL_CLOBBERS	"lr", "cc", "memory", \
+							"s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", \
+							"s8", "s9", "s10", "s11", "s12", "s13", "s14", "s15"
+#else
+#define SYSCALL_CLOBBERS	"lr", "cc", "memory"
+#endif
+
+/*
+ * port_syscall()
+ * Brief	: Calls a kernel service through SVC
+ * Param	: @num - System call number (svc.h)
+ * 			: @a0-a3 - Arguments of the service
+ * Retval	: Return value of the service
+ * Note		: The service runs in privileged Thread mode on the caller's stack,
+ * 			  so it may block like a direct call. It clobbers what any function
+ * 			  call does (SYSCALL_CLOBBERS).
+ */
+static inline uint32_t port_syscall(uint32_t num, uint32_t a0, uint32_t a1,
+									uint32_t a2, uint32_t a3)
+{
+	register uint32_t r0 __asm ("r0") = a0;
+	register uint32_t r1 __asm ("r1") = a1;
+	register uint32_t r2 __asm ("r2") = a2;
+	register uint32_t r3 __asm ("r3") = a3;
+	register uint32_t r12 __asm ("r12") = num;
+
+	__asm volatile ("svc 0"
+					: "+r" (r0), "+r" (r1), "+r" (r2), "+r" (r3), "+r" (r12)
+					:
+					: SYSCALL_CLOBBERS);
+
+	return r0;
+} /* End of port_syscall */
+
+/*
+ * port_syscall5()
+ * Brief	: Calls a kernel service that takes five arguments through SVC
+ * Param	: @num - System call number (svc.h)
+ * 			: @a0-a4 - Arguments of the service
+ * Retval	: Return value of the service
+ * Note		: a4 is stored where the service expects its fifth argument: At
+ * 			  the stack pointer it is called with, which is the one of the SVC
+ * 			  instruction (8 bytes are reserved to keep the stack aligned).
+ */
+static inline uint32_t port_syscall5(uint32_t num, uint32_t a0, uint32_t a1,
+									 uint32_t a2, uint32_t a3, uint32_t a4)
+{
+	register uint32_t r0 __asm ("r0") = a0;
+	register uint32_t r1 __asm ("r1") = a1;
+	register uint32_t r2 __asm ("r2") = a2;
+	register uint32_t r3 __asm ("r3") = a3;
+	register uint32_t r12 __asm ("r12") = num;
+
+	__asm volatile ("sub sp, sp, #8\n\t"
+					"str %[a4], [sp]\n\t"
+					"svc 0\n\t"
+					"add sp, sp, #8"
+					: "+r" (r0), "+r" (r1), "+r" (r2), "+r" (r3), "+r" (r12)
+					: [a4] "r" (a4)
+					: SYSCALL_CLOBBERS);
+
+	return r0;
+} /* End of port_syscall5 */
+
+#endif /* port_cm4.h */
@@ -0,0 +1,357 @@
+/*******************************************************************************
+ * File		: port_posix.c
+ * Brief	: Linux/POSIX simulation port of the RTOS kernel
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * The whole kernel runs in a single host thread:
+ *
+ * 	- Each task has its own ucontext_t, stored at the top of its stack. The
+ * 	  "psp" in the TCB points to it.
+ * 	- SIGALRM from a periodic ITIMER_REAL is the SysTick interrupt.
+ * 	- irq_masked plays PRIMASK. The signal itself is never blocked by the
+ * 	  kernel; the handler sees the mask and leaves the tick pending instead,
+ * 	  so masking and unmasking cost no system call.
+ * 	- A pended context switch (PendSV) is taken when the tick "ISR" returns
+ * 	  or when thread code unmasks interrupts, just as PendSV tail-chains on
+ * 	  the target.
+ *
+ * Tasks must not call non reentrant C library functions (e.g., printf) from
+ * more than one task unless they do so with interrupts disabled, since a tick
+ * may switch tasks in the middle of the call.
+ */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include "kernel.h"
+
+/* Emulated processor state */
+volatile sig_atomic_t irq_masked = 1;	/* PRIMASK; interrupts are off until the first task runs */
+volatile sig_atomic_t in_isr;			/* Running the tick "ISR" */
+volatile sig_atomic_t tick_pending;		/* SysTick pending */
+volatile sig_atomic_t switch_pending;	/* PendSV pending */
+uint32_t critical_nesting;				/* Depth of the current critical section */
+
+/*
+ * port_switch()
+ * Brief	: Performs context switching from curr_tcb to next_tcb (PendSV)
+ * Param	: None
+ * Retval	: None
+ * Note		: Called with interrupts masked. Returns when the calling task is
+ * 			  switched back in.
+ */
+static void port_switch(void)
+{
+	TCB_t *prev = curr_tcb;
+
+	/* Same task: Nothing to switch */
+	if (next_tcb == prev)
+		return;
+
+#if STACK_CHECK
+	/* Same check as PendSV_Handler() on the target (The saved context lives
+	   in the ucontext_t, so only the paint is checked) */
+	if (*(uint32_t *)prev->stack_base != STACK_PAINT)
+	{
+		fprintf(stderr, "Stack overflow (Task %p)\n", (void *)prev);
+		abort();
+	}
+#endif
+
+	curr_tcb = next_tcb;
+	swapcontext((ucontext_t *)prev->psp, (ucontext_t *)curr_tcb->psp);
+} /* End of port_switch */
+
+/*
+ * port_run_pending()
+ * Brief	: Takes the tick and context switch that became pending while
+ * 			  interrupts were masked
+ * Param	: None
+ * Retval	: None
+ * Note		: Called from thread code right after unmasking.
+ */
+static void port_run_pending(void)
+{
+	while (tick_pending || switch_pending)
+	{
+		irq_masked = 1;
+
+		if (tick_pending)
+		{
+			tick_pending = 0;
+			in_isr = 1;
+			kernel_tick();
+			in_isr = 0;
+		}
+
+		if (switch_pending)
+		{
+			switch_pending = 0;
+			port_switch();
+		}
+
+		irq_masked = 0;
+	}
+} /* End of port_run_pending */
+
+/*
+ * port_tick_handler()
+ * Brief	: SIGALRM handler; the SysTick interrupt of the simulation
+ * Param	: @sig - Signal number (Unused)
+ * Retval	: None
+ * Note		: The context switch is done from within the handler. The task that
+ * 			  is switched out resumes here later and returns from the signal,
+ * 			  which restores its signal mask.
+ */
+static void port_tick_handler(int sig)
+{
+	(void)sig;
+
+	/* Interrupts masked: leave the tick pending */
+	if (irq_masked)
+	{
+		tick_pending = 1;
+		return;
+	}
+
+	irq_masked = 1;
+	in_isr = 1;
+	tick_pending = 0;
+	kernel_tick();
+	in_isr = 0;
+
+	/* PendSV tail-chains */
+	if (switch_pending)
+	{
+		switch_pending = 0;
+		port_switch();
+	}
+
+	irq_masked = 0;
+} /* End of port_tick_handler */
+
+/*
+ * port_enter_critical()
+ * Brief	: Enters a (possibly nested) critical section
+ * Param	: None
+ * Retval	: None
+ * Note		: The simulation has a single interrupt level, so this is
+ * 			  the same mask as port_disable_interrupts().
+ */
+void port_enter_critical(void)
+{
+	irq_masked = 1;
+	critical_nesting++;
+} /* End of port_enter_critical */
+
+/*
+ * port_exit_critical()
+ * Brief	: Exits a critical section; the outermost exit unmasks the emulated
+ * 			  interrupts and takes whatever became pending
+ * Param	: None
+ * Retval	: None
+ * Note		: N/A
+ */
+void port_exit_critical(void)
+{
+	if (--critical_nesting == 0U)
+		port_enable_interrupts();
+} /* End of port_exit_critical */
+
+/*
+ * port_disable_interrupts()
+ * Brief	: Masks the emulated interrupts
+ * Param	: None
+ * Retval	: None
+ * Note		: N/A
+ */
+void port_disable_interrupts(void)
+{
+	irq_masked = 1;
+} /* End of port_disable_interrupts */
+
+/*
+ * port_enable_interrupts()
+ * Brief	: Unmasks the emulated interrupts and takes whatever became pending
+ * Param	: None
+ * Retval	: None
+ * Note		: Within the tick "ISR" the pending work is taken on its way out.
+ */
+void port_enable_interrupts(void)
+{
+	if (in_isr)
+		return;
+
+	irq_masked = 0;
+	port_run_pending();
+} /* End of port_enable_interrupts */
+
+/*
+ * port_pend_context_switch()
+ * Brief	: Pends the emulated PendSV exception
+ * Param	: None
+ * Retval	: None
+ * Note		: N/A
+ */
+void port_pend_context_switch(void)
+{
+	switch_pending = 1;
+} /* End of port_pend_context_switch */
+
+/*
+ * port_cycle_count()
+ * Brief	: Returns a free-running 32-bit timestamp
+ * Param	: None
+ * Retval	: Monotonic time in nanoseconds (Truncated to 32 bits)
+ * Note		: Stands in for the DWT cycle counter.
+ */
+uint32_t port_cycle_count(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+} /* End of port_cycle_count */
+
+/*
+ * port_task_entry()
+ * Brief	: First code run by every task
+ * Param	: None
+ * Retval	: None
+ * Note		: A task is always first switched in with interrupts masked.
+ */
+static void port_task_entry(void)
+{
+	irq_masked = 0;
+	port_run_pending();
+
+	(curr_tcb->task_handler)(curr_tcb->arg);
+
+	/* Task handlers must not return */
+	fprintf(stderr, "port_posix: task handler returned\n");
+	abort();
+} /* End of port_task_entry */
+
+/*
+ * port_init_stack()
+ * Brief	: Builds the initial context of a task
+ * Param	: @stack_base - Lowest address of the task stack
+ * 			: @stack_size - Stack size in bytes
+ * 			: @task_handler - Pointer to task handler
+ * 			: @arg - Argument passed to the task handler
+ * Retval	: Address of the task's ucontext_t (Kept in the TCB as its psp)
+ * Note		: The ucontext_t sits at the top of the stack area, the rest is
+ * 			  the stack the task runs on. The handler and its argument are
+ * 			  taken from curr_tcb when the task first runs.
+ */
+uintptr_t port_init_stack(uintptr_t stack_base, uint32_t stack_size,
+						  void (*task_handler)(void *), void *arg)
+{
+	uintptr_t top = stack_base + stack_size;
+	ucontext_t *uc = (ucontext_t *)((top - sizeof(ucontext_t)) & ~(uintptr_t)15);
+
+	(void)task_handler;
+	(void)arg;
+
+	getcontext(uc);
+	uc->uc_stack.ss_sp = (void *)stack_base;
+	uc->uc_stack.ss_size = (uintptr_t)uc - stack_base;
+	uc->uc_link = NULL;
+	sigemptyset(&uc->uc_sigmask);	/* Tasks run with SIGALRM deliverable */
+	makecontext(uc, port_task_entry, 0);
+
+	return (uintptr_t)uc;
+} /* End of port_init_stack */
+
+/*
+ * port_idle()
+ * Brief	: Sleeps until the next interrupt (tick)
+ * Param	: @idle_ticks - Number of ticks until the earliest wakeup
+ * Retval	: Number of ticks to add to the tick count (Always 0)
+ * Note		: Called by the idle task with interrupts disabled. The simulation
+ * 			  keeps its periodic tick, so it only waits for it, like WFI.
+ */
+uint32_t port_idle(uint32_t idle_ticks)
+{
+	sigset_t block_mask;
+	sigset_t wait_mask;
+
+	(void)idle_ticks;
+
+	/* Block SIGALRM while checking for a pending tick so that it cannot be
+	   delivered between the check and the wait */
+	sigemptyset(&block_mask);
+	sigaddset(&block_mask, SIGALRM);
+	sigprocmask(SIG_BLOCK, &block_mask, &wait_mask);
+
+	if (!tick_pending)
+		sigsuspend(&wait_mask);
+
+	sigprocmask(SIG_SETMASK, &wait_mask, NULL);
+
+	return 0;
+} /* End of port_idle */
+
+/*
+ * port_init()
+ * Brief	: Installs the tick handler
+ * Param	: None
+ * Retval	: None
+ * Note		: N/A
+ */
+void port_init(void)
+{
+	struct sigaction sa;
+
+	sa.sa_handler = port_tick_handler;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART;
+	sigaction(SIGALRM, &sa, NULL);
+} /* End of port_init */
+
+/*
+ * port_start_first_task()
+ * Brief	: Starts the periodic tick and switches to curr_tcb
+ * Param	: None
+ * Retval	: None (Does not return)
+ * Note		: N/A
+ */
+void port_start_first_task(void)
+{
+	struct itimerval it;
+
+	/* No tick may be taken before the first task is running */
+	irq_masked = 1;
+
+	it.it_interval.tv_sec = 0;
+	it.it_interval.tv_usec = 1000000 / TICK_HZ;
+	it.it_value = it.it_interval;
+	setitimer(ITIMER_REAL, &it, NULL);
+
+	setcontext((ucontext_t *)curr_tcb->psp);
+} /* End of port_start_first_task */
+
+/*
+ * port_access_ok()
+ * Brief	: Tells whether the running task may access a memory range itself
+ * Param	: @addr - Start of the range
+ * 			: @size - Size of the range in bytes
+ * Retval	: 1 (Tasks share the whole address space with the kernel)
+ * Note		: No system calls on the host, so svc_args_ok() never gets here.
+ */
+uint32_t port_access_ok(uintptr_t addr, uint32_t size)
+{
+	(void)addr;
+	(void)size;
+
+	return 1;
+} /* End of port_access_ok */
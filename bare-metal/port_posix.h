@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * File		: port_posix.h
+ * Brief	: Linux/POSIX simulation port definitions
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef PORT_POSIX_H
+#define PORT_POSIX_H
+
+#include <stdint.h>
+
+/* Each task stack also holds the ucontext_t of the task, and host C library
+   calls need far more stack than on the target */
+#define MIN_STACK_SIZE		(16U * 1024U)
+#define SIZE_IDLE_STACK		MIN_STACK_SIZE
+
+/* No hardware limit on a single idle period */
+#define MAX_IDLE_TICKS		0x7FFFFFFFU
+
+/* Interrupts are emulated: SIGALRM plays SysTick, and a software flag plays
+   PRIMASK. A tick that arrives while masked stays pending, exactly like the
+   SysTick exception, and is taken as soon as the mask is cleared. */
+#define ENTER_CRITICAL()		port_enter_critical()
+#define EXIT_CRITICAL()			port_exit_critical()
+#define DISABLE_INTERRUPTS()	port_disable_interrupts()
+#define ENABLE_INTERRUPTS()		port_enable_interrupts()
+#define PEND_CONTEXT_SWITCH()	port_pend_context_switch()
+#define CYCLE_COUNT()			port_cycle_count()	/* Nanoseconds */
+
+/* Tasks and the tick "ISR" share one host thread, so ordering the compiler's
+   accesses is enough */
+#define MEMORY_BARRIER()		__atomic_signal_fence(__ATOMIC_SEQ_CST)
+
+/* Tasks run at the same (only) privilege level as the kernel: No system calls
+   (svc.h) */
+#define TASK_CONTROL			0U
+#define IS_PRIVILEGED()			1
+#define SYSCALL(num, a0, a1, a2, a3)			0U
+#define SYSCALL5(num, a0, a1, a2, a3, a4)		0U
+
+/* No linker script: Everything stays where the host toolchain puts it */
+#define SECTION(name)
+#define KERNEL_DATA
+
+/* No memory protection: Stacks only need the 8-byte alignment of the ABI */
+#define MPU_ENABLED				0U
+#define STACK_GUARD_SIZE		0U
+#define STACK_SIZE_ROUND(size)	(((size) + 7U) & ~7U)
+#define STACK_ALIGN(size)		8U
+
+/* The host C library keeps its own malloc() (heap.h) */
+#define HEAP_NEWLIB				0U
+
+void port_enter_critical(void);
+void port_exit_critical(void);
+void port_disable_interrupts(void);
+void port_enable_interrupts(void);
+void port_pend_context_switch(void);
+uint32_t port_cycle_count(void);
+
+#endif /* port_posix.h */
@@ -0,0 +1,227 @@
+/*******************************************************************************
+ * File		: ringbuf.c
+ * Brief	: Implementation of the lock-free single-producer/single-consumer
+ * 			  ring buffer
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * Meant for handing data (e.g., sensor samples) from one ISR to one task
+ * without masking interrupts:
+ *
+ * 	- head is only ever written by the producer and tail only by the consumer.
+ * 	  Both are aligned 32-bit words, so each side reads the other's index with
+ * 	  a single load and never needs a read-modify-write on shared data. (With
+ * 	  only one writer per word, LDREX/STREX would add nothing.)
+ * 	- The indices run freely and wrap at 2^32; head - tail is the number of
+ * 	  elements, and the slot is index & mask.
+ * 	- MEMORY_BARRIER() (DMB) makes a slot's contents visible before the index
+ * 	  that publishes it, and the slot read complete before the index that
+ * 	  frees it.
+ *
+ * The consumer may instead block in ringbuf_get_wait(). The producer then
+ * wakes it through the scheduler, which only costs it a load of the wait
+ * queue head while nobody is waiting. Waking takes a critical section, so
+ * ringbuf_put() is limited to the ISRs that may call into the kernel (At or
+ * below KERNEL_INTERRUPT_PRIORITY); a producer above that ceiling uses
+ * ringbuf_put_nowake(), which never touches the kernel.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "ringbuf.h"
+#include "svc.h"
+
+/*
+ * ringbuf_init()
+ * Brief	: Initializes an empty ring buffer
+ * Param	: @rb - Ring buffer to initialize
+ * 			: @storage - Memory for num_elems elements
+ * 			: @elem_size - Size of an element in bytes
+ * 			: @num_elems - Number of slots (A power of 2)
+ * Retval	: E_OK on success, E_INVALID on invalid arguments
+ * Note		: Must not be called while the ring buffer is in use.
+ */
+int ringbuf_init(ringbuf_t *rb, void *storage, uint32_t elem_size, uint32_t num_elems)
+{
+	if ((rb == NULL) || (storage == NULL) || (elem_size == 0) ||
+		(num_elems == 0) || ((num_elems & (num_elems - 1U)) != 0))
+	{
+		return E_INVALID;
+	}
+
+	rb->storage = storage;
+	rb->elem_size = elem_size;
+	rb->mask = num_elems - 1U;
+	rb->head = 0;
+	rb->tail = 0;
+	rb->wait_queue.head = NULL;
+	rb->wait_queue.order = WAIT_FIFO;
+
+	return E_OK;
+} /* End of ringbuf_init */
+
+/*
+ * ringbuf_put_nowake()
+ * Brief	: Copies an element into the ring buffer without waking the
+ * 			  consumer (Producer side)
+ * Param	: @rb - Ring buffer
+ * 			: @elem - Element to copy in
+ * Retval	: E_OK on success, E_FULL if there is no free slot
+ * Note		: Never blocks and never masks interrupts, so it is the one for
+ * 			  ISRs above KERNEL_INTERRUPT_PRIORITY, which must not enter the
+ * 			  kernel. A consumer waiting in ringbuf_get_wait() only sees the
+ * 			  element on its timeout, or once something calls ringbuf_wake()
+ * 			  (e.g., an ISR at or below the kernel priority pended by the
+ * 			  producer).
+ */
+int ringbuf_put_nowake(ringbuf_t *rb, const void *elem)
+{
+	uint32_t head = rb->head;
+
+	if ((head - rb->tail) > rb->mask)
+		return E_FULL;
+
+	memcpy(&rb->storage[(head & rb->mask) * rb->elem_size], elem, rb->elem_size);
+
+	/* Publish the element only once it is in the slot */
+	MEMORY_BARRIER();
+	rb->head = head + 1U;
+
+	return E_OK;
+} /* End of ringbuf_put_nowake */
+
+/*
+ * ringbuf_put()
+ * Brief	: Copies an element into the ring buffer (Producer side)
+ * Param	: @rb - Ring buffer
+ * 			: @elem - Element to copy in
+ * Retval	: E_OK on success, E_FULL if there is no free slot
+ * Note		: Never blocks, and only masks interrupts to wake a consumer that
+ * 			  is waiting in ringbuf_get_wait(). Can be called from an ISR at
+ * 			  or below KERNEL_INTERRUPT_PRIORITY (Numerically at or above);
+ * 			  ISRs above it use ringbuf_put_nowake().
+ */
+int ringbuf_put(ringbuf_t *rb, const void *elem)
+{
+	if (ringbuf_put_nowake(rb, elem) != E_OK)
+		return E_FULL;
+
+	/* Wake hook */
+	if (rb->wait_queue.head != NULL)
+		ringbuf_wake(rb);
+
+	return E_OK;
+} /* End of ringbuf_put */
+
+/*
+ * ringbuf_wake()
+ * Brief	: Wakes up the consumer waiting in ringbuf_get_wait(), if any
+ * Param	: @rb - Ring buffer
+ * Retval	: E_OK
+ * Note		: Called by ringbuf_put() when the wait queue is not empty.
+ */
+int ringbuf_wake(ringbuf_t *rb)
+{
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_RINGBUF_WAKE, rb, 0, 0, 0);
+
+	ENTER_CRITICAL();
+	if (kernel_wake(&rb->wait_queue, E_OK) != NULL)
+		schedule();
+	EXIT_CRITICAL();
+
+	return E_OK;
+} /* End of ringbuf_wake */
+
+/*
+ * ringbuf_get()
+ * Brief	: Copies the oldest element out of the ring buffer (Consumer side)
+ * Param	: @rb - Ring buffer
+ * 			: @elem - Where to copy the element to
+ * Retval	: E_OK on success, E_TIMEOUT if the ring buffer is empty
+ * Note		: Never blocks and never masks interrupts.
+ */
+int ringbuf_get(ringbuf_t *rb, void *elem)
+{
+	uint32_t tail = rb->tail;
+
+	if (rb->head == tail)
+		return E_TIMEOUT;
+
+	/* Read the slot only after seeing the index that published it */
+	MEMORY_BARRIER();
+	memcpy(elem, &rb->storage[(tail & rb->mask) * rb->elem_size], rb->elem_size);
+
+	/* Free the slot only once it has been read */
+	MEMORY_BARRIER();
+	rb->tail = tail + 1U;
+
+	return E_OK;
+} /* End of ringbuf_get */
+
+/*
+ * ringbuf_get_wait()
+ * Brief	: Copies the oldest element out of the ring buffer, waiting for one
+ * 			  if it is empty (Consumer side)
+ * Param	: @rb - Ring buffer
+ * 			: @elem - Where to copy the element to (NULL: Only wait until the
+ * 					  ring buffer is not empty)
+ * 			: @timeout - Maximum number of ticks to wait (NO_WAIT: Do not wait,
+ * 						 WAIT_FOREVER: No limit)
+ * Retval	: E_OK on success, E_TIMEOUT if nothing arrived in time
+ * Note		: Tasks only. The emptiness check and the wait are done with
+ * 			  interrupts masked, so a put from an ISR cannot slip in between
+ * 			  and leave the consumer waiting on a non-empty buffer.
+ */
+int ringbuf_get_wait(ringbuf_t *rb, void *elem, uint32_t timeout)
+{
+	if ((elem != NULL) && (ringbuf_get(rb, elem) == E_OK))
+		return E_OK;
+
+	if (timeout == NO_WAIT)
+		return E_TIMEOUT;
+
+	/* Only waiting needs the kernel; the fast path above stays a plain call.
+	   The element is then copied out by the caller itself, so the kernel
+	   never writes to elem on its behalf. */
+	if (!IS_PRIVILEGED())
+	{
+		if ((int)SYSCALL(SYS_RINGBUF_GET_WAIT, rb, NULL, timeout, 0) != E_OK)
+			return E_TIMEOUT;
+
+		return (elem == NULL) ? E_OK : ringbuf_get(rb, elem);
+	}
+
+	ENTER_CRITICAL();
+
+	if (rb->head != rb->tail)
+	{
+		EXIT_CRITICAL();
+		return (elem == NULL) ? E_OK : ringbuf_get(rb, elem);
+	}
+
+	kernel_wait(&rb->wait_queue, timeout);
+
+	/* Switched out here, until the producer puts an element or timed out */
+	EXIT_CRITICAL();
+
+	if (curr_tcb->wait_result != E_OK)
+		return E_TIMEOUT;
+
+	return (elem == NULL) ? E_OK : ringbuf_get(rb, elem);
+} /* End of ringbuf_get_wait */
+
+/*
+ * ringbuf_count()
+ * Brief	: Returns the number of elements in the ring buffer
+ * Param	: @rb - Ring buffer
+ * Retval	: Number of elements (May be stale by the time it is used)
+ * Note		: N/A
+ */
+uint32_t ringbuf_count(ringbuf_t *rb)
+{
+	return rb->head - rb->tail;
+} /* End of ringbuf_count */
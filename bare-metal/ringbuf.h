@@ -0,0 +1,42 @@
+/*******************************************************************************
+ * File		: ringbuf.h
+ * Brief	: Interface for the lock-free single-producer/single-consumer ring
+ * 			  buffer
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/* Ring buffer of fixed-size elements; statically allocated by the application
+   along with its storage (num_elems * elem_size bytes). Putting and getting
+   never mask interrupts, except for ringbuf_put() waking a consumer blocked in
+   ringbuf_get_wait(): That enters the kernel, so ringbuf_put() may only be
+   called from tasks and from ISRs at or below KERNEL_INTERRUPT_PRIORITY. An
+   ISR above it must use ringbuf_put_nowake(), which never wakes the consumer
+   (It then has to poll, time out, or be woken by ringbuf_wake() from an ISR
+   the kernel allows). */
+typedef struct
+{
+	uint8_t *storage;				/* Element slots */
+	uint32_t elem_size;				/* Size of an element in bytes */
+	uint32_t mask;					/* Number of slots - 1 (Power of 2) */
+	volatile uint32_t head;			/* Free-running put index (Written by the producer only) */
+	volatile uint32_t tail;			/* Free-running get index (Written by the consumer only) */
+	wait_queue_t wait_queue;		/* Consumer blocked in ringbuf_get_wait() */
+} ringbuf_t;
+
+/* Ring buffer interface */
+int ringbuf_init(ringbuf_t *rb, void *storage, uint32_t elem_size, uint32_t num_elems);
+int ringbuf_put(ringbuf_t *rb, const void *elem);
+int ringbuf_put_nowake(ringbuf_t *rb, const void *elem);
+int ringbuf_get(ringbuf_t *rb, void *elem);
+int ringbuf_get_wait(ringbuf_t *rb, void *elem, uint32_t timeout);
+int ringbuf_wake(ringbuf_t *rb);
+uint32_t ringbuf_count(ringbuf_t *rb);
+
+#endif /* ringbuf.h */
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * File		: sem.c
+ * Brief	: Implementation of counting and binary semaphores
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sem.h"
+#include "svc.h"
+
+/*
+ * semaphore_init()
+ * Brief	: Initializes a semaphore
+ * Param	: @sem - Semaphore to initialize
+ * 			: @initial_count - Number of units available at first
+ * 			: @max_count - Upper bound of the count (SEM_BINARY for a binary
+ * 						   semaphore)
+ * 			: @order - Order the waiters are served in (WAIT_FIFO or
+ * 					   WAIT_PRIORITY)
+ * Retval	: E_OK on success, E_INVALID on invalid arguments
+ * Note		: Must not be called while tasks may be using the semaphore.
+ */
+int semaphore_init(semaphore_t *sem, uint32_t initial_count, uint32_t max_count,
+				   uint8_t order)
+{
+	if ((sem == NULL) || (max_count == 0) || (initial_count > max_count) ||
+		((order != WAIT_FIFO) && (order != WAIT_PRIORITY)))
+	{
+		return E_INVALID;
+	}
+
+	sem->count = initial_count;
+	sem->max_count = max_count;
+	sem->wait_queue.head = NULL;
+	sem->wait_queue.order = order;
+
+	return E_OK;
+} /* End of semaphore_init */
+
+/*
+ * semaphore_take()
+ * Brief	: Takes a unit of the semaphore, waiting for one if none is
+ * 			  available
+ * Param	: @sem - Semaphore to take
+ * 			: @timeout - Maximum number of ticks to wait (NO_WAIT: Do not wait,
+ * 						 WAIT_FOREVER: No limit)
+ * Retval	: E_OK if a unit was taken, E_TIMEOUT if none became available in
+ * 			  time
+ * Note		: The waiting task is not polled: It is WAITING until
+ * 			  semaphore_give() hands it a unit or the timeout expires. From an
+ * 			  ISR or the idle task, only NO_WAIT may be used.
+ */
+int semaphore_take(semaphore_t *sem, uint32_t timeout)
+{
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_SEMAPHORE_TAKE, sem, timeout, 0, 0);
+
+	ENTER_CRITICAL();
+
+	if (sem->count > 0)
+	{
+		sem->count--;
+		EXIT_CRITICAL();
+		return E_OK;
+	}
+
+	if (timeout == NO_WAIT)
+	{
+		EXIT_CRITICAL();
+		return E_TIMEOUT;
+	}
+
+	kernel_wait(&sem->wait_queue, timeout);
+
+	/* Switched out here, until given a unit or timed out */
+	EXIT_CRITICAL();
+
+	return curr_tcb->wait_result;
+} /* End of semaphore_take */
+
+/*
+ * semaphore_give()
+ * Brief	: Gives a unit back to the semaphore
+ * Param	: @sem - Semaphore to give
+ * Retval	: E_OK on success, E_INVALID if the count is already at max_count
+ * Note		: If a task is waiting, the unit is handed to it directly and it
+ * 			  is made READY; it preempts the caller right away if it has a
+ * 			  higher priority. Can be called from an ISR.
+ */
+int semaphore_give(semaphore_t *sem)
+{
+	int ret = E_OK;
+
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_SEMAPHORE_GIVE, sem, 0, 0, 0);
+
+	ENTER_CRITICAL();
+
+	if (kernel_wake(&sem->wait_queue, E_OK) != NULL)
+		schedule();
+	else if (sem->count < sem->max_count)
+		sem->count++;
+	else
+		ret = E_INVALID;
+
+	EXIT_CRITICAL();
+
+	return ret;
+} /* End of semaphore_give */
+
+/*
+ * semaphore_count()
+ * Brief	: Returns the number of available units
+ * Param	: @sem - Semaphore
+ * Retval	: Current count
+ * Note		: N/A
+ */
+uint32_t semaphore_count(semaphore_t *sem)
+{
+	return sem->count;
+} /* End of semaphore_count */
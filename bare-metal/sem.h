@@ -0,0 +1,32 @@
+/*******************************************************************************
+ * File		: sem.h
+ * Brief	: Interface for counting and binary semaphores
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef SEM_H
+#define SEM_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/* Maximum count of a binary semaphore */
+#define SEM_BINARY			1U
+
+/* Semaphore; statically allocated by the application */
+typedef struct
+{
+	uint32_t count;					/* Number of available units */
+	uint32_t max_count;				/* Upper bound of count (SEM_BINARY: Binary) */
+	wait_queue_t wait_queue;		/* Tasks blocked in semaphore_take() */
+} semaphore_t;
+
+/* Semaphore interface */
+int semaphore_init(semaphore_t *sem, uint32_t initial_count, uint32_t max_count,
+				   uint8_t order);
+int semaphore_take(semaphore_t *sem, uint32_t timeout);
+int semaphore_give(semaphore_t *sem);
+uint32_t semaphore_count(semaphore_t *sem);
+
+#endif /* sem.h */
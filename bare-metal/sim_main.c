@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * File		: sim_main.c
+ * Brief	: Host simulation application to exercise and profile the kernel
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * Usage: ./rtos_sim [num_tasks] [seconds]
+ *
+ * Creates num_tasks sleeper tasks spread over a few priority levels, each
+ * blocking for its own period, and runs them for the given number of seconds.
+ * Run it under 'perf record' to profile the scheduler, blocking and tick paths
+ * with the very same kernel.c that runs on the target.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "kernel.h"
+
+#define NUM_SIM_PRIORITIES	4U		/* Sleeper tasks use priorities 1..4 */
+#define REPORT_PRIORITY		(NUM_PRIORITIES - 1U)
+
+/* Function prototypes */
+void sleeper_handler(void *arg);	/* Sleeper tasks */
+void report_handler(void *arg);		/* Reporter task */
+
+/* Number of wakeups of each sleeper task */
+uint32_t wakeups[MAX_TASKS];
+
+uint32_t num_sleepers = 64;
+uint32_t run_seconds = 5;
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1)
+		num_sleepers = (uint32_t)strtoul(argv[1], NULL, 0);
+
+	if (argc > 2)
+		run_seconds = (uint32_t)strtoul(argv[2], NULL, 0);
+
+	/* Idle and reporter tasks take two TCBs */
+	if (num_sleepers > (MAX_TASKS - 2U))
+		num_sleepers = MAX_TASKS - 2U;
+
+	printf("Simulating %u tasks for %u s\n", (unsigned)num_sleepers, (unsigned)run_seconds);
+
+	/* Create tasks */
+	for (uint32_t i = 0; i < num_sleepers; i++)
+	{
+		if (task_create(sleeper_handler, (void *)(uintptr_t)i, MIN_STACK_SIZE,
+						(uint8_t)(1U + (i % NUM_SIM_PRIORITIES))) == NULL)
+		{
+			printf("task_create() failed for task %u\n", (unsigned)i);
+			return 1;
+		}
+	}
+
+	task_create(report_handler, NULL, MIN_STACK_SIZE, REPORT_PRIORITY);
+
+	/* Start kernel */
+	start_kernel();
+
+	/* Not reached */
+	return 0;
+} /* End of main */
+
+/*
+ * sleeper_handler()
+ * Brief	: Blocks for a task specific period (1..50 ticks) forever
+ * Param	: @arg - Index of the task
+ * Retval	: None
+ * Note		: N/A
+ */
+void sleeper_handler(void *arg)
+{
+	uint32_t id = (uint32_t)(uintptr_t)arg;
+	uint32_t period = 1U + (id % 50U);
+
+	while (1)
+	{
+		block_task(period);
+		wakeups[id]++;
+	}
+} /* End of sleeper_handler */
+
+/*
+ * report_handler()
+ * Brief	: Prints the number of wakeups every second, then exits
+ * Param	: @arg - Unused
+ * Retval	: None
+ * Note		: The only task using stdio (See port_posix.c).
+ */
+void report_handler(void *arg)
+{
+	uint64_t total;
+
+	for (uint32_t sec = 1; sec <= run_seconds; sec++)
+	{
+		block_task(TICK_HZ);
+
+		total = 0;
+		for (uint32_t i = 0; i < num_sleepers; i++)
+			total += wakeups[i];
+
+		printf("[%3u s] ticks: %u, wakeups: %llu", (unsigned)sec,
+			   (unsigned)get_tick_count(), (unsigned long long)total);
+#if KERNEL_STATS
+		printf(", tick max: %u ns", (unsigned)kernel_stats.tick_isr_cycles_max);
+#endif
+		printf("\n");
+	}
+
+	exit(0);
+} /* End of report_handler */
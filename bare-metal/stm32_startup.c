@@ -6,6 +6,10 @@
 
 #define STACK_START	SRAM_END
 
+/* Coprocessor Access Control Register */
+#define CPACR		(*(uint32_t volatile *)0xE000ED88)
+#define CP10_CP11_FULL_ACCESS	(0xFU << 20)	/* CP10/CP11 = FPU */
+
 /* Linker symbols */
 extern uint32_t _etext;		/* End of .text section */
 extern uint32_t _sdata;		/* Start of .data section */
@@ -13,6 +17,8 @@ extern uint32_t _edata;		/* End of .data section */
 extern uint32_t _sbss;		/* start of .bss section */
 extern uint32_t _ebss;		/* End of .bss section */
 extern uint32_t _la_data;	/* End of .bss section */
+extern uint32_t _sccmram;	/* Start of .ccmram section */
+extern uint32_t _eccmram;	/* End of .ccmram section */
 
 /* Function prototypes */
 
@@ -245,6 +251,14 @@ void Default_Handler(void)
 
 void Reset_Handler(void)
 {
+#if defined(__ARM_FP)
+	/* Built for the hardware FPU: Grant access to it before any floating-point
+	   instruction (e.g., in the C library init) can be executed */
+	CPACR |= CP10_CP11_FULL_ACCESS;
+	__asm volatile ("dsb");
+	__asm volatile ("isb");
+#endif
+
 	/* Copy .data section from FLASH to SRAM */
 	uint32_t size = (uint32_t)&_edata - (uint32_t)&_sdata;	
 
@@ -271,6 +285,16 @@ void Reset_Handler(void)
 		*pDst++ = 0;	/* Zero out .bss section */
 	}
 
+	/* Initialize .ccmram section (in CCM RAM) to zero; it holds .bss-like
+	   kernel data */
+	size = (uint32_t)&_eccmram - (uint32_t)&_sccmram;
+	pDst = (uint8_t *)&_sccmram;
+
+	for (uint32_t i = 0; i < size; i++)
+	{
+		*pDst++ = 0;
+	}
+
 	/* Call init function of standard library (Required only when standard library
 	   functions are used in the project) */
 	__libc_init_array();	/* Initialize C standard library */
@@ -0,0 +1,133 @@
+/*******************************************************************************
+ * File		: svc.c
+ * Brief	: System call dispatch table
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "svc.h"
+#include "sem.h"
+#include "mutex.h"
+#include "msgq.h"
+#include "event.h"
+#include "ringbuf.h"
+#include "workq.h"
+#include "timer.h"
+#include "mempool.h"
+#include "heap.h"
+
+/* Kernel services reachable from unprivileged tasks, by system call number */
+const svc_handler_t svc_table[NUM_SYSCALLS] =
+{
+	[SYS_TASK_CREATE]		= (svc_handler_t)task_create,
+	[SYS_BLOCK_TASK]		= (svc_handler_t)block_task,
+	[SYS_TASK_DELAY_UNTIL]	= (svc_handler_t)task_delay_until,
+	[SYS_TASK_NOTIFY]		= (svc_handler_t)task_notify,
+	[SYS_TASK_NOTIFY_WAIT]	= (svc_handler_t)task_notify_wait,
+	[SYS_SEMAPHORE_TAKE]	= (svc_handler_t)semaphore_take,
+	[SYS_SEMAPHORE_GIVE]	= (svc_handler_t)semaphore_give,
+	[SYS_MUTEX_LOCK]		= (svc_handler_t)mutex_lock,
+	[SYS_MUTEX_UNLOCK]		= (svc_handler_t)mutex_unlock,
+	[SYS_MSGQ_SEND]			= (svc_handler_t)msgq_send,
+	[SYS_MSGQ_RECEIVE]		= (svc_handler_t)msgq_receive,
+	[SYS_EVENT_GROUP_WAIT]	= (svc_handler_t)event_group_wait,
+	[SYS_EVENT_GROUP_SET]	= (svc_handler_t)event_group_set,
+	[SYS_EVENT_GROUP_CLEAR]	= (svc_handler_t)event_group_clear,
+	[SYS_RINGBUF_GET_WAIT]	= (svc_handler_t)ringbuf_get_wait,
+	[SYS_RINGBUF_WAKE]		= (svc_handler_t)ringbuf_wake,
+	[SYS_SOFT_TIMER_START]	= (svc_handler_t)soft_timer_start,
+	[SYS_SOFT_TIMER_STOP]	= (svc_handler_t)soft_timer_stop,
+	[SYS_MEMPOOL_ALLOC]		= (svc_handler_t)mempool_alloc,
+	[SYS_MEMPOOL_FREE]		= (svc_handler_t)mempool_free,
+	[SYS_MEMPOOL_GET_STATS]	= (svc_handler_t)mempool_get_stats,
+	[SYS_HEAP_ALLOC]		= (svc_handler_t)heap_alloc,
+	[SYS_HEAP_FREE]			= (svc_handler_t)heap_free,
+	[SYS_HEAP_REALLOC]		= (svc_handler_t)heap_realloc,
+	[SYS_HEAP_GET_STATS]	= (svc_handler_t)heap_get_stats,
+	[SYS_GET_TICK_COUNT]	= (svc_handler_t)get_tick_count,
+	[SYS_SOFT_TIMER_WAIT_EXPIRED]	= (svc_handler_t)soft_timer_wait_expired,
+#if STACK_CHECK
+	[SYS_TASK_STACK_HIGH_WATER]	= (svc_handler_t)task_stack_high_water,
+#else
+	[SYS_TASK_STACK_HIGH_WATER]	= NULL,
+#endif
+#if SCHED_EDF
+	[SYS_TASK_SET_DEADLINE]	= (svc_handler_t)task_set_deadline,
+#else
+	[SYS_TASK_SET_DEADLINE]	= NULL,
+#endif
+};
+
+/* Arguments in r0-r3 of each system call (svc_args_ok()); calls not listed
+   take no pointer at all */
+const uint16_t svc_args[NUM_SYSCALLS][4] =
+{
+	[SYS_TASK_DELAY_UNTIL]	= { SVC_PTR(sizeof(uint32_t)) },
+	[SYS_TASK_NOTIFY]		= { SVC_TASK },
+	[SYS_TASK_NOTIFY_WAIT]	= { SVC_VAL, SVC_PTR_OPT(sizeof(uint32_t)) },
+	[SYS_SEMAPHORE_TAKE]	= { SVC_PTR(sizeof(semaphore_t)) },
+	[SYS_SEMAPHORE_GIVE]	= { SVC_PTR(sizeof(semaphore_t)) },
+	[SYS_MUTEX_LOCK]		= { SVC_PTR(sizeof(mutex_t)) },
+	[SYS_MUTEX_UNLOCK]		= { SVC_PTR(sizeof(mutex_t)) },
+	[SYS_MSGQ_SEND]			= { SVC_PTR(sizeof(msgq_t)) },		/* The message is not read */
+	[SYS_MSGQ_RECEIVE]		= { SVC_PTR(sizeof(msgq_t)), SVC_PTR(sizeof(void *)) },
+	[SYS_EVENT_GROUP_WAIT]	= { SVC_PTR(sizeof(event_group_t)), SVC_VAL, SVC_VAL,
+								SVC_PTR_OPT(sizeof(uint32_t)) },
+	[SYS_EVENT_GROUP_SET]	= { SVC_PTR(sizeof(event_group_t)) },
+	[SYS_EVENT_GROUP_CLEAR]	= { SVC_PTR(sizeof(event_group_t)) },
+	[SYS_RINGBUF_GET_WAIT]	= { SVC_PTR(sizeof(ringbuf_t)), SVC_NULL },	/* Waits only */
+	[SYS_RINGBUF_WAKE]		= { SVC_PTR(sizeof(ringbuf_t)) },
+	[SYS_SOFT_TIMER_START]	= { SVC_PTR(sizeof(soft_timer_t)) },
+	[SYS_SOFT_TIMER_STOP]	= { SVC_PTR(sizeof(soft_timer_t)) },
+	[SYS_MEMPOOL_ALLOC]		= { SVC_PTR(sizeof(mempool_t)) },
+	[SYS_MEMPOOL_FREE]		= { SVC_PTR(sizeof(mempool_t)), SVC_PTR(sizeof(void *)) },
+	[SYS_MEMPOOL_GET_STATS]	= { SVC_PTR(sizeof(mempool_t)), SVC_PTR(sizeof(mempool_stats_t)) },
+	[SYS_HEAP_GET_STATS]	= { SVC_PTR(sizeof(heap_stats_t)) },	/* heap_free() checks its own */
+	[SYS_SOFT_TIMER_WAIT_EXPIRED]	= { SVC_PTR(sizeof(void *)), SVC_PTR(sizeof(void *)) },
+	[SYS_TASK_STACK_HIGH_WATER]	= { SVC_TASK },
+	[SYS_TASK_SET_DEADLINE]	= { SVC_TASK },
+};
+
+/*
+ * svc_args_ok()
+ * Brief	: Checks the arguments of a system call before it is run
+ * Param	: @num - System call number (Valid)
+ * 			: @args - Arguments in r0-r3 of the caller (Its exception frame)
+ * Retval	: 1 if every pointer and task handle is one the caller may pass,
+ * 			  0 otherwise
+ * Note		: Called by the port on entry, still in the caller's SVC
+ * 			  exception; curr_tcb is the caller.
+ */
+int svc_args_ok(uint32_t num, const uint32_t *args)
+{
+	for (uint32_t i = 0; i < 4U; i++)
+	{
+		uint16_t kind = svc_args[num][i];
+
+		if (kind == SVC_VAL)
+			continue;
+
+		if (args[i] == 0U)
+		{
+			if ((kind & (SVC_ARG_PTR | SVC_ARG_OPT)) == SVC_ARG_PTR)
+				return 0;	/* NULL where the service needs a pointer */
+		}
+		else if (kind == SVC_NULL)
+		{
+			return 0;
+		}
+		else if (kind == SVC_TASK)
+		{
+			if (!task_is_valid((TCB_t *)(uintptr_t)args[i]))
+				return 0;
+		}
+		else if (!port_access_ok(args[i], SVC_ARG_SIZE(kind)))
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+} /* End of svc_args_ok */
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * File		: svc.h
+ * Brief	: System call numbers and dispatch table
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef SVC_H
+#define SVC_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/*
+ * Every kernel service a task may call checks IS_PRIVILEGED() first. An
+ * unprivileged caller is turned into SYSCALL(SYS_..., args): The port raises
+ * the privilege for the duration of the call and runs the very same function
+ * again, which then takes the direct path. Privileged callers (ISRs, the idle
+ * task, main() before start_kernel()) never pay for the system call.
+ *
+ * The service then writes through the caller's pointers with the kernel's
+ * privilege, so the port checks them first against svc_args[]: Each pointer
+ * argument must point to memory the calling task could access itself
+ * (port_access_ok()), and each task handle to a TCB in use
+ * (task_is_valid()). A call that fails the check is treated like the memory
+ * access it stands for: As a MemManage fault.
+ *
+ * This catches a task's mistakes, not a hostile task: The objects themselves
+ * (Semaphores, mutexes, queues, event groups, ring buffers, timers, pools)
+ * live in application memory, and the services follow the kernel pointers
+ * stored in them (Wait queue links, owner TCBs, message queue slots, timer
+ * and pool links) unchecked. A task that overwrites those can make the kernel
+ * read or write anywhere, CCM RAM included. The kernel is not isolated from
+ * the tasks; that would take kernel-owned objects behind handles.
+ */
+
+/* System call numbers (Index into svc_table[]) */
+#define SYS_TASK_CREATE			0U
+#define SYS_BLOCK_TASK			1U
+#define SYS_TASK_DELAY_UNTIL	2U
+#define SYS_TASK_NOTIFY			3U
+#define SYS_TASK_NOTIFY_WAIT	4U
+#define SYS_SEMAPHORE_TAKE		5U
+#define SYS_SEMAPHORE_GIVE		6U
+#define SYS_MUTEX_LOCK			7U
+#define SYS_MUTEX_UNLOCK		8U
+#define SYS_MSGQ_SEND			9U
+#define SYS_MSGQ_RECEIVE		10U
+#define SYS_EVENT_GROUP_WAIT	11U
+#define SYS_EVENT_GROUP_SET		12U
+#define SYS_EVENT_GROUP_CLEAR	13U
+#define SYS_RINGBUF_GET_WAIT	14U
+#define SYS_RINGBUF_WAKE		15U
+#define SYS_SOFT_TIMER_START	16U
+#define SYS_SOFT_TIMER_STOP		17U
+#define SYS_MEMPOOL_ALLOC		18U
+#define SYS_MEMPOOL_FREE		19U
+#define SYS_MEMPOOL_GET_STATS	20U
+#define SYS_HEAP_ALLOC			21U
+#define SYS_HEAP_FREE			22U
+#define SYS_HEAP_REALLOC		23U
+#define SYS_HEAP_GET_STATS		24U
+#define SYS_GET_TICK_COUNT		25U
+#define SYS_SOFT_TIMER_WAIT_EXPIRED	26U	/* Timer daemon only */
+#define SYS_TASK_STACK_HIGH_WATER	27U	/* STACK_CHECK only */
+#define SYS_TASK_SET_DEADLINE	28U		/* SCHED_EDF only */
+#define NUM_SYSCALLS			29U
+
+/* Ends a system call (Issued by the port, not by the services) */
+#define SYS_RETURN				0xFFU
+
+/* Kernel service as stored in the dispatch table; it is called with the
+   caller's own arguments, whatever its real prototype is */
+typedef void (*svc_handler_t)(void);
+
+/* Kinds of the arguments in r0-r3 of a system call (svc_args[]); the fifth
+   one, if any, is never a pointer */
+#define SVC_VAL					0U			/* Not dereferenced by the service */
+#define SVC_PTR(size)			(0x1000U | (size))	/* Points to size bytes */
+#define SVC_PTR_OPT(size)		(0x3000U | (size))	/* Same, or NULL */
+#define SVC_TASK				0x4000U		/* Task handle, or NULL */
+#define SVC_NULL				0x8000U		/* Must be NULL */
+#define SVC_ARG_PTR				0x1000U
+#define SVC_ARG_OPT				0x2000U
+#define SVC_ARG_SIZE(arg)		((arg) & 0x0FFFU)
+
+extern const svc_handler_t svc_table[NUM_SYSCALLS];
+extern const uint16_t svc_args[NUM_SYSCALLS][4];
+
+int svc_args_ok(uint32_t num, const uint32_t *args);
+
+#endif /* svc.h */
@@ -146,14 +146,18 @@ int _execve(char *name, char **argv, char **env)
 caddr_t _sbrk(int incr)
 {
 	extern char end asm("end");
+	extern char _heap_limit;
 	static char *heap_end;
 	char *prev_heap_end;
 
 	if (heap_end == 0)
 		heap_end = &end;
 
+	/* Bounded by a linker symbol, not by a stack pointer: The task stacks and
+	   the scheduler stack (MSP) live in CCM RAM, below SRAM. Nothing calls
+	   this while heap.c provides malloc() (HEAP_NEWLIB). */
 	prev_heap_end = heap_end;
-	if (heap_end + incr > stack_ptr)
+	if (heap_end + incr > &_heap_limit)
 	{
 		errno = ENOMEM;
 		return (caddr_t) -1;
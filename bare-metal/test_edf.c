@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * File		: test_edf.c
+ * Brief	: Host test of the ready list order under SCHED_EDF
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * Usage: make test (Builds with -DPORT_POSIX -DSCHED_EDF=1 and runs it)
+ *
+ * Checks the order ready_list_insert() gives the READY tasks of one priority
+ * level: Tasks with a deadline by nearest deadline (FIFO among equal ones),
+ * then the tasks without a deadline in FIFO (Round-robin) order, however
+ * often they are re-inserted. Exits with 1 on the first mismatch.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "kernel.h"
+
+#if !SCHED_EDF
+#error "test_edf.c must be built with -DSCHED_EDF=1"
+#endif
+
+#define TEST_PRIORITY		3U
+#define NUM_TEST_TASKS		5U
+
+/* Kernel internals under test (kernel.c) */
+extern TCB_t *ready_list[NUM_PRIORITIES];
+void ready_list_insert(TCB_t *tcb);
+void ready_list_remove(TCB_t *tcb);
+
+/* Function prototypes */
+void test_handler(void *arg);
+void check_order(const char *step, uint32_t num, const uint32_t *expected);
+void reinsert(uint32_t id);
+
+TCB_t *tasks[NUM_TEST_TASKS];
+uint32_t num_failed;
+
+int main(void)
+{
+	/* T0..T2 without a deadline: FIFO */
+	for (uint32_t i = 0; i < 3U; i++)
+		tasks[i] = task_create(test_handler, (void *)(uintptr_t)i, MIN_STACK_SIZE, TEST_PRIORITY);
+
+	check_order("create T0 T1 T2", 3U, (const uint32_t []){ 0, 1, 2 });
+
+	/* Re-inserting one (e.g., after it blocked) sends it to the tail */
+	reinsert(0);
+	check_order("reinsert T0", 3U, (const uint32_t []){ 1, 2, 0 });
+
+	reinsert(2);
+	check_order("reinsert T2", 3U, (const uint32_t []){ 1, 0, 2 });
+
+	/* Tasks with a deadline go ahead of them, nearest deadline first */
+	tasks[3] = task_create(test_handler, (void *)3U, MIN_STACK_SIZE, TEST_PRIORITY);
+	tasks[4] = task_create(test_handler, (void *)4U, MIN_STACK_SIZE, TEST_PRIORITY);
+	task_set_deadline(tasks[3], 20U);
+	task_set_deadline(tasks[4], 10U);
+	check_order("deadlines T3=20 T4=10", 5U, (const uint32_t []){ 4, 3, 1, 0, 2 });
+
+	/* An equal deadline does not take the head */
+	task_set_deadline(tasks[3], 10U);
+	check_order("deadline T3=10", 5U, (const uint32_t []){ 4, 3, 1, 0, 2 });
+
+	/* And a task without a deadline still goes to the very tail */
+	reinsert(1);
+	check_order("reinsert T1", 5U, (const uint32_t []){ 4, 3, 0, 2, 1 });
+
+	/* Dropping the deadline makes it a round-robin task again */
+	task_set_deadline(tasks[4], NO_DEADLINE);
+	check_order("no deadline T4", 5U, (const uint32_t []){ 3, 0, 2, 1, 4 });
+
+	printf("%s\n", (num_failed == 0) ? "EDF order: OK" : "EDF order: FAILED");
+
+	return (num_failed == 0) ? 0 : 1;
+} /* End of main */
+
+/*
+ * test_handler()
+ * Brief	: Body of the test tasks
+ * Param	: @arg - Unused
+ * Retval	: None
+ * Note		: Never runs; the kernel is not started.
+ */
+void test_handler(void *arg)
+{
+	(void)arg;
+
+	while (1);
+} /* End of test_handler */
+
+/*
+ * reinsert()
+ * Brief	: Takes a task out of the ready list and makes it READY again
+ * Param	: @id - Index of the task in tasks[]
+ * Retval	: None
+ * Note		: What blocking and waking the task does to the ready list.
+ */
+void reinsert(uint32_t id)
+{
+	ready_list_remove(tasks[id]);
+	ready_list_insert(tasks[id]);
+} /* End of reinsert */
+
+/*
+ * check_order()
+ * Brief	: Compares the ready list of TEST_PRIORITY with the expected order
+ * Param	: @step - Name of the step, for the report
+ * 			: @num - Number of tasks expected in the list
+ * 			: @expected - Indexes in tasks[], from the head
+ * Retval	: None
+ * Note		: Counts a mismatch in num_failed.
+ */
+void check_order(const char *step, uint32_t num, const uint32_t *expected)
+{
+	TCB_t *node = ready_list[TEST_PRIORITY];
+	uint32_t ok = 1;
+
+	for (uint32_t i = 0; i < num; i++)
+	{
+		if (node != tasks[expected[i]])
+			ok = 0;
+
+		node = node->next;
+	}
+
+	if (node != ready_list[TEST_PRIORITY])
+		ok = 0;
+
+	printf("%-24s: ", step);
+
+	node = ready_list[TEST_PRIORITY];
+	for (uint32_t i = 0; i < num; i++, node = node->next)
+		printf("T%u ", (unsigned)(uintptr_t)node->arg);
+
+	printf("%s\n", ok ? "OK" : "FAILED");
+
+	if (!ok)
+		num_failed++;
+} /* End of check_order */
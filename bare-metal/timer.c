@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * File		: timer.c
+ * Brief	: Implementation of software timers
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * One-shot and auto-reload timers share a single daemon task, so a periodic
+ * activity no longer needs a task and a stack of its own:
+ *
+ * 	- Active timers are kept in a list sorted by expiry tick (Wrap-safe), so
+ * 	  the daemon only ever looks at the head.
+ * 	- The daemon sleeps in the kernel until the head expires, i.e. SysTick
+ * 	  wakes it up through the sleep queue. The tick itself does no timer
+ * 	  work, and tickless idle sleeps right up to the next expiry.
+ * 	- An auto-reload timer is reloaded from its previous expiry, not from the
+ * 	  time its callback ran, so it does not drift. After an overrun, the
+ * 	  missed expiries run back to back.
+ *
+ * Callbacks run one after the other in the daemon task, at TIMER_PRIORITY;
+ * they must not block for long, or they delay every other timer. The daemon
+ * is an unprivileged task like the others: Timers live in application memory,
+ * so a task could otherwise have its own function run privileged by filling
+ * in a timer. Callbacks use the kernel through system calls, and can't
+ * submit work to the (Privileged) work queue.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "timer.h"
+#include "svc.h"
+
+/* Active timers, earliest expiry first */
+static soft_timer_t *timer_list KERNEL_DATA;
+
+/* Timer daemon task */
+static TCB_t *timer_task KERNEL_DATA;
+
+/*
+ * timer_list_insert()
+ * Brief	: Inserts a timer in the active list by expiry
+ * Param	: @timer - Timer to insert
+ * Retval	: None
+ * Note		: Must be called in a critical section. Timers with the same
+ * 			  expiry run in the order they were started.
+ */
+static void timer_list_insert(soft_timer_t *timer)
+{
+	soft_timer_t *prev = NULL;
+	soft_timer_t *curr = timer_list;
+
+	while ((curr != NULL) && ((int32_t)(curr->expiry - timer->expiry) <= 0))
+	{
+		prev = curr;
+		curr = curr->next;
+	}
+
+	timer->prev = prev;
+	timer->next = curr;
+
+	if (curr != NULL)
+		curr->prev = timer;
+
+	if (prev != NULL)
+		prev->next = timer;
+	else
+		timer_list = timer;
+
+	timer->active = 1;
+} /* End of timer_list_insert */
+
+/*
+ * timer_list_remove()
+ * Brief	: Removes a timer from the active list
+ * Param	: @timer - Active timer
+ * Retval	: None
+ * Note		: Must be called in a critical section.
+ */
+static void timer_list_remove(soft_timer_t *timer)
+{
+	if (timer->prev != NULL)
+		timer->prev->next = timer->next;
+	else
+		timer_list = timer->next;
+
+	if (timer->next != NULL)
+		timer->next->prev = timer->prev;
+
+	timer->next = NULL;
+	timer->prev = NULL;
+	timer->active = 0;
+} /* End of timer_list_remove */
+
+/*
+ * soft_timer_wait_expired()
+ * Brief	: Waits for the next timer to expire and takes it off the active
+ * 			  list (Timer daemon only)
+ * Param	: @callback - Where to store the callback of the expired timer
+ * 			: @arg - Where to store its argument
+ * Retval	: E_OK once a timer has expired, E_INVALID if the caller is not
+ * 			  the timer daemon
+ * Note		: The privileged half of the daemon: An auto-reload timer is put
+ * 			  back in the list here, and the daemon then runs the callback
+ * 			  with its own (Task) privilege. Woken up early by
+ * 			  soft_timer_start() when a timer becomes the head of the list.
+ */
+int soft_timer_wait_expired(void (**callback)(void *), void **arg)
+{
+	soft_timer_t *timer;
+	uint32_t now;
+	uint32_t timeout;
+
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_SOFT_TIMER_WAIT_EXPIRED, callback, arg, 0, 0);
+
+	if (curr_tcb != timer_task)
+		return E_INVALID;
+
+	while (1)
+	{
+		ENTER_CRITICAL();
+
+		now = get_tick_count();
+		timer = timer_list;
+
+		if ((timer != NULL) && ((int32_t)(now - timer->expiry) >= 0))
+		{
+			timer_list_remove(timer);
+
+			if (timer->period != TIMER_ONE_SHOT)
+			{
+				timer->expiry += timer->period;
+				timer_list_insert(timer);
+			}
+
+			*callback = timer->callback;
+			*arg = timer->arg;
+
+			EXIT_CRITICAL();
+
+			return E_OK;
+		}
+
+		timeout = (timer != NULL) ? (timer->expiry - now) : WAIT_FOREVER;
+
+		EXIT_CRITICAL();
+
+		/* A timer started in between has left a notification pending */
+		task_notify_wait(0xFFFFFFFFU, NULL, timeout);
+	}
+} /* End of soft_timer_wait_expired */
+
+/*
+ * timer_handler()
+ * Brief	: Timer daemon task; runs the callbacks of the expired timers
+ * Param	: @arg - Unused
+ * Retval	: None
+ * Note		: Runs with the privilege of any other task (TASK_CONTROL), so a
+ * 			  callback can't do more than the task that set the timer could.
+ */
+static void timer_handler(void *arg)
+{
+	void (*callback)(void *);
+	void *cb_arg;
+
+	(void)arg;
+
+	while (1)
+	{
+		if (soft_timer_wait_expired(&callback, &cb_arg) == E_OK)
+			callback(cb_arg);
+	}
+} /* End of timer_handler */
+
+/*
+ * soft_timer_service_init()
+ * Brief	: Creates the timer daemon task
+ * Param	: None
+ * Retval	: E_OK on success, E_INVALID if the task could not be created
+ * Note		: To be called once, before start_kernel(). The daemon runs
+ * 			  unprivileged (Unless UNPRIVILEGED_TASKS is 0), since it runs
+ * 			  the callbacks; it manages the active list through a system
+ * 			  call (soft_timer_wait_expired()).
+ */
+int soft_timer_service_init(void)
+{
+	timer_task = task_create(timer_handler, NULL, TIMER_STACK_SIZE, TIMER_PRIORITY);
+
+	if (timer_task == NULL)
+		return E_INVALID;
+
+	return E_OK;
+} /* End of soft_timer_service_init */
+
+/*
+ * soft_timer_init()
+ * Brief	: Initializes a stopped timer
+ * Param	: @timer - Timer to initialize
+ * 			: @callback - Function to run on expiry (In the daemon task)
+ * 			: @arg - Argument passed to callback
+ * Retval	: E_OK on success, E_INVALID on invalid arguments
+ * Note		: Must not be called while the timer is active.
+ */
+int soft_timer_init(soft_timer_t *timer, void (*callback)(void *), void *arg)
+{
+	if ((timer == NULL) || (callback == NULL))
+		return E_INVALID;
+
+	timer->callback = callback;
+	timer->arg = arg;
+	timer->expiry = 0;
+	timer->period = TIMER_ONE_SHOT;
+	timer->active = 0;
+	timer->next = NULL;
+	timer->prev = NULL;
+
+	return E_OK;
+} /* End of soft_timer_init */
+
+/*
+ * soft_timer_start()
+ * Brief	: Starts (Or restarts) a timer
+ * Param	: @timer - Timer to start
+ * 			: @delay - Ticks until the first expiry (At least 1)
+ * 			: @period - Ticks between the following expiries (TIMER_ONE_SHOT:
+ * 						Expire only once)
+ * Retval	: E_OK on success, E_INVALID if delay is 0
+ * Note		: Can be called from an ISR or a timer callback. An active timer
+ * 			  is rescheduled from now. An unprivileged caller's timer must lie
+ * 			  in memory the caller can access (Checked by the system call).
+ */
+int soft_timer_start(soft_timer_t *timer, uint32_t delay, uint32_t period)
+{
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_SOFT_TIMER_START, timer, delay, period, 0);
+
+	if (delay == 0)
+		return E_INVALID;
+
+	ENTER_CRITICAL();
+
+	if (timer->active)
+		timer_list_remove(timer);
+
+	timer->expiry = get_tick_count() + delay;
+	timer->period = period;
+	timer_list_insert(timer);
+
+	/* The daemon sleeps until the former head expires */
+	if ((timer_list == timer) && (timer_task != NULL))
+		task_notify(timer_task, 0, NOTIFY_GIVE);
+
+	EXIT_CRITICAL();
+
+	return E_OK;
+} /* End of soft_timer_start */
+
+/*
+ * soft_timer_stop()
+ * Brief	: Stops a timer
+ * Param	: @timer - Timer to stop
+ * Retval	: E_OK
+ * Note		: Can be called from an ISR or a timer callback (Including its own).
+ * 			  Stopping a timer that is not active does nothing.
+ */
+int soft_timer_stop(soft_timer_t *timer)
+{
+	if (!IS_PRIVILEGED())
+		return (int)SYSCALL(SYS_SOFT_TIMER_STOP, timer, 0, 0, 0);
+
+	ENTER_CRITICAL();
+
+	/* If it was the head, the daemon still wakes up at its expiry, finds
+	   nothing due and sleeps again */
+	if (timer->active)
+		timer_list_remove(timer);
+
+	EXIT_CRITICAL();
+
+	return E_OK;
+} /* End of soft_timer_stop */
+
+/*
+ * soft_timer_is_active()
+ * Brief	: Tells whether a timer is running
+ * Param	: @timer - Timer
+ * Retval	: 1 if it will expire again, 0 otherwise
+ * Note		: N/A
+ */
+int soft_timer_is_active(soft_timer_t *timer)
+{
+	return timer->active;
+} /* End of soft_timer_is_active */
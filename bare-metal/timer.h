@@ -0,0 +1,48 @@
+/*******************************************************************************
+ * File		: timer.h
+ * Brief	: Interface for software timers
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/* Priority of the timer daemon task; callbacks run at this priority, and
+   unprivileged (Like any task, see UNPRIVILEGED_TASKS) */
+#ifndef TIMER_PRIORITY
+#define TIMER_PRIORITY		(NUM_PRIORITIES - 2U)
+#endif
+
+/* Stack of the timer daemon task; all the callbacks run on it */
+#ifndef TIMER_STACK_SIZE
+#define TIMER_STACK_SIZE	((SIZE_TASK_STACK > MIN_STACK_SIZE) ? SIZE_TASK_STACK : MIN_STACK_SIZE)
+#endif
+
+/* Period of a timer that expires only once (soft_timer_start()) */
+#define TIMER_ONE_SHOT		0U
+
+/* Software timer; statically allocated by the application */
+typedef struct soft_timer
+{
+	void (*callback)(void *);		/* Function run by the timer daemon on expiry */
+	void *arg;						/* Argument passed to it */
+	uint32_t expiry;				/* Tick of the next expiry */
+	uint32_t period;				/* Reload period in ticks (TIMER_ONE_SHOT: None) */
+	uint8_t active;					/* Started and not expired (Or auto-reload) */
+	struct soft_timer *next;		/* Next timer in the active list (Later expiry) */
+	struct soft_timer *prev;		/* Previous timer in the active list (Earlier expiry) */
+} soft_timer_t;
+
+/* Software timer interface */
+int soft_timer_service_init(void);
+int soft_timer_init(soft_timer_t *timer, void (*callback)(void *), void *arg);
+int soft_timer_start(soft_timer_t *timer, uint32_t delay, uint32_t period);
+int soft_timer_stop(soft_timer_t *timer);
+int soft_timer_is_active(soft_timer_t *timer);
+int soft_timer_wait_expired(void (**callback)(void *), void **arg);
+
+#endif /* timer.h */
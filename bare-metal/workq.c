@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * File		: workq.c
+ * Brief	: Implementation of the deferred work queue (Bottom halves)
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+/*
+ * An ISR does the urgent part of its job (e.g., reading a data register and
+ * clearing the interrupt), then hands the rest to workq_submit(). The work
+ * item is a function and its argument; it is queued in O(1) and run later by
+ * the worker task, in FIFO order:
+ *
+ * 	- Runs preemptible, with interrupts enabled, and at a priority the
+ * 	  scheduler knows about (WORKQ_PRIORITY), so long processing no longer
+ * 	  adds to the latency of every other interrupt.
+ * 	- May call any kernel service, blocking ones included (Though that delays
+ * 	  the work queued after it).
+ *
+ * The worker is only notified when the queue goes from empty to non-empty;
+ * it drains the whole queue before waiting again.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "workq.h"
+
+/* Circular queue of work items */
+static work_t workq[WORKQ_SIZE] KERNEL_DATA;
+static uint32_t workq_read KERNEL_DATA;
+static uint32_t workq_count KERNEL_DATA;
+
+/* Worker task */
+static TCB_t *workq_task KERNEL_DATA;
+
+/*
+ * workq_get()
+ * Brief	: Dequeues the oldest work item
+ * Param	: @work - Where to copy the work item to
+ * Retval	: 1 if a work item was dequeued, 0 if the queue is empty
+ * Note		: N/A
+ */
+static int workq_get(work_t *work)
+{
+	ENTER_CRITICAL();
+
+	if (workq_count == 0)
+	{
+		EXIT_CRITICAL();
+		return 0;
+	}
+
+	*work = workq[workq_read];
+	workq_read = (workq_read + 1U) % WORKQ_SIZE;
+	workq_count--;
+
+	EXIT_CRITICAL();
+
+	return 1;
+} /* End of workq_get */
+
+/*
+ * workq_handler()
+ * Brief	: Worker task; runs the submitted work items as they come
+ * Param	: @arg - Unused
+ * Retval	: None
+ * Note		: N/A
+ */
+static void workq_handler(void *arg)
+{
+	work_t work;
+
+	while (1)
+	{
+		task_notify_wait(0xFFFFFFFFU, NULL, WAIT_FOREVER);
+
+		while (workq_get(&work))
+			work.func(work.arg);
+	}
+} /* End of workq_handler */
+
+/*
+ * workq_init()
+ * Brief	: Creates the worker task
+ * Param	: None
+ * Retval	: E_OK on success, E_INVALID if the task could not be created
+ * Note		: To be called once, before start_kernel(). The worker runs
+ * 			  privileged, like an ISR, since deferred work often finishes
+ * 			  what an ISR started on the hardware.
+ */
+int workq_init(void)
+{
+	workq_task = task_create(workq_handler, NULL, WORKQ_STACK_SIZE, WORKQ_PRIORITY);
+
+	if (workq_task == NULL)
+		return E_INVALID;
+
+	workq_task->control = 0U;
+
+	return E_OK;
+} /* End of workq_init */
+
+/*
+ * workq_submit()
+ * Brief	: Queues a function to be run by the worker task
+ * Param	: @func - Function to run
+ * 			: @arg - Argument passed to func
+ * Retval	: E_OK on success, E_FULL if WORKQ_SIZE items are already pending,
+ * 			  E_INVALID if func is NULL or the caller is unprivileged
+ * Note		: Never blocks; meant to be called from ISRs, but works from
+ * 			  privileged tasks as well. Unprivileged tasks can't submit work,
+ * 			  since the worker would run their function privileged. The same
+ * 			  function may be queued more than once.
+ */
+int workq_submit(void (*func)(void *), void *arg)
+{
+	uint32_t slot;
+
+	/* The work would run privileged: Not a system call */
+	if (!IS_PRIVILEGED() || (func == NULL))
+		return E_INVALID;
+
+	ENTER_CRITICAL();
+
+	if (workq_count == WORKQ_SIZE)
+	{
+		EXIT_CRITICAL();
+		return E_FULL;
+	}
+
+	slot = (workq_read + workq_count) % WORKQ_SIZE;
+	workq[slot].func = func;
+	workq[slot].arg = arg;
+
+	/* The worker drains the queue before it waits again, so only the first
+	   item needs to wake it up */
+	if (workq_count++ == 0)
+		task_notify(workq_task, 0, NOTIFY_GIVE);
+
+	EXIT_CRITICAL();
+
+	return E_OK;
+} /* End of workq_submit */
+
+/*
+ * workq_pending()
+ * Brief	: Returns the number of work items not run yet
+ * Param	: None
+ * Retval	: Number of work items (Not counting the one running)
+ * Note		: N/A
+ */
+uint32_t workq_pending(void)
+{
+	return workq_count;
+} /* End of workq_pending */
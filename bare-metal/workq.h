@@ -0,0 +1,42 @@
+/*******************************************************************************
+ * File		: workq.h
+ * Brief	: Interface for the deferred work queue (Bottom halves)
+ * Author	: Kyungjae Lee
+ * Date		: 05/04/2023
+ ******************************************************************************/
+
+#ifndef WORKQ_H
+#define WORKQ_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+/* Capacity of the queue (Work items submitted but not run yet) */
+#ifndef WORKQ_SIZE
+#define WORKQ_SIZE			16U
+#endif
+
+/* Priority of the worker task; deferred work preempts every other task by
+   default, but never an ISR */
+#ifndef WORKQ_PRIORITY
+#define WORKQ_PRIORITY		(NUM_PRIORITIES - 1U)
+#endif
+
+/* Stack of the worker task; all the deferred functions run on it */
+#ifndef WORKQ_STACK_SIZE
+#define WORKQ_STACK_SIZE	((SIZE_TASK_STACK > MIN_STACK_SIZE) ? SIZE_TASK_STACK : MIN_STACK_SIZE)
+#endif
+
+/* Deferred function and its argument */
+typedef struct
+{
+	void (*func)(void *);			/* Function to run in the worker task */
+	void *arg;						/* Argument passed to it */
+} work_t;
+
+/* Deferred work queue interface */
+int workq_init(void);
+int workq_submit(void (*func)(void *), void *arg);
+uint32_t workq_pending(void);
+
+#endif /* workq.h */